@@ -4,9 +4,11 @@
 #define Tangair_usb2can_motor_imu_H
 
 #include <vector>
+#include <array>
 #include <string>
 #include <thread>
 #include <atomic>
+#include <mutex>
 #include <cmath>
 #include <iostream>
 
@@ -19,8 +21,20 @@
 #include <chrono>
 #include <stdio.h>
 #include <signal.h>
-#include "usb_can.h"
+#include "can_transport.h"
+#include "dm_motor_protocol.h"
+#include "mit_codec.h"
+#include "flight_recorder.h"
+#include "stage_latency.h"
+#include "command_validator.h"
+#include "command_interpolator.h"
 #include "config_loader.h"
+#include "callback_handler.h"
+#include "io_reactor.h"
+#include "seqlock.h"
+#include "latency_histogram.h"
+#include "rt_time.h"
+#include "rt_thread.h"
 
 #include <math.h>
 #include <unitree/robot/channel/channel_publisher.hpp>
@@ -36,8 +50,8 @@
 using Matrix3x4d = Eigen::Matrix<double, 3, 4>;
 
 // 辅助函数
-Matrix3x4d mujoco_ang2real_ang(const std::vector<double>& dof_pos);
-std::vector<double> real_ang2mujoco_ang(const std::vector<double>& dof_pos);
+Matrix3x4d mujoco_ang2real_ang(const std::array<double, 12>& dof_pos);
+std::array<double, 12> real_ang2mujoco_ang(const Matrix3x4d& real_ang);
 
 void PrintMatrix(const std::string& name, const Eigen::Matrix<double, 3, 4>& matrix);
 
@@ -45,34 +59,6 @@ float uint_to_float(int x_int, float x_min, float x_max, int bits);
 int float_to_uint(float x, float x_min, float x_max, int bits);
 
 
-//达妙其他电机参数    {P, V, T}
-				// {12.5, 30, 10 }, // DM4310
-				// {12.5, 50, 10 }, // DM4310_48V
-				// {12.5, 8, 28 },  // DM4340
-				// {12.5, 10, 28 }, // DM4340_48V
-				// {12.5, 45, 20 }, // DM6006
-				// {12.5, 45, 40 }, // DM8006
-				// {12.5, 45, 54 }, // DM8009
-				// {12.5,25,  200}, // DM10010L
-				// {12.5,20, 200},  // DM10010
-				// {12.5,280,1},    // DMH3510
-				// {12.5,45,10},    // DMH6215
-				// {12.5,45,10}     // DMG6220
-
-// 达妙电机,此处为DM8006参数
-#define P_MIN -12.5f
-#define P_MAX 12.5f
-#define V_MIN -45.0f
-#define V_MAX 45.0f
-#define T_MIN_8006 -40.0f
-#define T_MAX_8006 40.0f
-#define T_MIN_8009 -54.0f
-#define T_MAX_8009 54.0f
-#define KP_MIN 0.0f
-#define KP_MAX 500.0f
-#define KD_MIN 0.0f
-#define KD_MAX 5.0f
-
 using namespace unitree::common;
 using namespace unitree::robot;
 
@@ -114,22 +100,168 @@ typedef struct
 	float current_speed_f;//
 	float current_torque_f;//
 
+	int64_t timestamp_ns; // 接收时的 CLOCK_MONOTONIC 时间
+	uint32_t cycle;		  // 对应的TX周期号
+
 } Motor_CAN_Recieve_Struct;
 
+// TX调度: 每一帧对应的适配器、通道与电机
 typedef struct
 {
-	Motor_CAN_Send_Struct ID_1_motor_send, ID_2_motor_send, ID_3_motor_send, ID_5_motor_send, ID_6_motor_send, ID_7_motor_send;
-	Motor_CAN_Recieve_Struct ID_1_motor_recieve, ID_2_motor_recieve, ID_3_motor_recieve, ID_5_motor_recieve, ID_6_motor_recieve, ID_7_motor_recieve;
+	uint8_t channel;
+	Motor_CAN_Send_Struct *motor;
+	uint8_t adapter;
+} CAN_TX_Slot_Struct;
 
-} USB2CAN_CAN_Bus_Struct;
+// RX解码表项: 反馈帧直接写入的目标结构体与该电机型号的扭矩换算参数
+typedef struct
+{
+	Motor_CAN_Recieve_Struct *recv;
+	float t_scale;
+	float t_offset;
+	int8_t joint; // DDS序号, -1 为未知帧
+} CAN_RX_Decode_Struct;
+
+// 12个关节的状态快照, 按DDS顺序排列, 通过 SeqLock 发布
+constexpr int NUM_MOTOR = 12;
+struct alignas(64) MotorStateBlock
+{
+	std::array<float, NUM_MOTOR> position;
+	std::array<float, NUM_MOTOR> velocity;
+	std::array<float, NUM_MOTOR> torque;
+
+	uint32_t cycle;						  // 快照对应的TX周期号
+	uint32_t stale_mask;				  // 第 i 位为1: 关节 i 本周期未收到反馈, 数值沿用旧样本
+	int64_t timestamp_ns;				  // 快照生成时间
+	std::array<int64_t, NUM_MOTOR> sample_ns; // 各关节样本的接收时间
+};
+
+// 单个关节的最近一帧反馈 (未乘关节方向), 由负责该适配器的接收线程经 SeqLock 发布
+struct JointFeedback
+{
+	float position;
+	float velocity;
+	float torque;
+	uint32_t cycle;		  // 所属TX周期号
+	int64_t timestamp_ns; // 接收时间
+};
+
+// DDS 线程交给实时循环的一条完整指令, 通过 SeqLock 发布
+// 各数组按 Matrix3x4d 列优先顺序存放, 可直接 Map 为矩阵
+struct alignas(64) LowCmdBlock
+{
+	uint64_t seq;		 // 第几条 LowCmd, 0 为尚未收到
+	int64_t arrival_ns;	 // 回调入口的时间
+	std::array<double, NUM_MOTOR> position; // 已换算为电机角度
+	std::array<double, NUM_MOTOR> velocity; // dq, 同样换算到电机方向, 供 cubic 插值
+	std::array<double, NUM_MOTOR> kp;
+	std::array<double, NUM_MOTOR> kd;
+};
+
+// 单个关节的反馈统计, 延迟为本周期发出指令帧到收到反馈帧
+struct MotorReplyStats
+{
+	uint64_t replies = 0;
+	uint64_t missed_cycles = 0; // 截止时仍未收到反馈的周期数
+	uint32_t last_cycle = 0;
+	int64_t last_rx_ns = 0;
+	int64_t latency_p50_ns = 0;
+	int64_t latency_p99_ns = 0;
+	int64_t latency_max_ns = 0;
+};
+
+// 关节描述表: 所在总线 (通道号), 电机ID, 方向, DDS序号, 电机型号, 所在适配器
+enum MotorType : uint8_t
+{
+	MOTOR_DM8006 = 0,
+	MOTOR_DM8009 = 1,
+};
+
+struct JointDescriptor
+{
+	uint8_t bus;
+	uint8_t can_id;
+	float sign;
+	uint8_t dds_index;
+	MotorType type;
+	uint8_t adapter = 0;
+};
+
+// 默认拓扑 (单适配器, can2 前腿, can1 后腿); 运行时的关节表由 config.yaml 的 can_topology 生成
+constexpr std::array<JointDescriptor, NUM_MOTOR> JOINT_MAP = {{
+	{2, 0x01,  1.0f,  0, MOTOR_DM8006}, // FRH
+	{2, 0x02, -1.0f,  1, MOTOR_DM8006}, // FRT
+	{2, 0x03, -1.0f,  2, MOTOR_DM8009}, // FRC
+	{2, 0x05,  1.0f,  3, MOTOR_DM8006}, // FLH
+	{2, 0x06,  1.0f,  4, MOTOR_DM8006}, // FLT
+	{2, 0x07,  1.0f,  5, MOTOR_DM8009}, // FLC
+	{1, 0x01, -1.0f,  6, MOTOR_DM8006}, // RRH
+	{1, 0x02, -1.0f,  7, MOTOR_DM8006}, // RRT
+	{1, 0x03, -1.0f,  8, MOTOR_DM8009}, // RRC
+	{1, 0x05, -1.0f,  9, MOTOR_DM8006}, // RLH
+	{1, 0x06,  1.0f, 10, MOTOR_DM8006}, // RLT
+	{1, 0x07,  1.0f, 11, MOTOR_DM8009}, // RLC
+}};
+
+// TX周期统计, 单位ns
+struct TxCycleStats
+{
+	int64_t last_ns = 0;
+	int64_t min_ns = 0;
+	int64_t max_ns = 0;
+	int64_t avg_ns = 0;
+	uint64_t cycles = 0;
+};
+
+// 实时控制循环统计, 单位ns
+struct RtLoopStats
+{
+	uint64_t cycles = 0;
+	uint64_t overruns = 0;		// 执行时间超过周期
+	uint64_t missed_ticks = 0;	// 错过的定时器节拍
+	int64_t jitter_p50_ns = 0;
+	int64_t jitter_p99_ns = 0;
+	int64_t jitter_max_ns = 0;
+	int64_t exec_p50_ns = 0;
+	int64_t exec_p99_ns = 0;
+	int64_t exec_max_ns = 0;
+};
+
+// 使能 / 失能 / 置零 / 阻尼序列中每个电机的结果
+enum class MotorAckStatus : uint8_t
+{
+	kSkipped,	// 不在本次序列中
+	kOk,		// 收到反馈且状态符合
+	kFault,		// 反馈带故障码
+	kTimeout,	// 重发后仍未收到符合的反馈
+};
+
+// 数组均按DDS序号排列
+struct MotorSequenceResult
+{
+	std::array<MotorAckStatus, NUM_MOTOR> status{};
+	std::array<uint8_t, NUM_MOTOR> state{};		// 最后一次反馈的状态码 (data[0] 高4位)
+	std::array<uint8_t, NUM_MOTOR> attempts{};	// 发送次数
+	int64_t elapsed_ns = 0;
+
+	bool AllOk() const
+	{
+		for (MotorAckStatus s : status)
+			if (s == MotorAckStatus::kFault || s == MotorAckStatus::kTimeout)
+				return false;
+		return true;
+	}
+};
 
 class Tangair_usb2can
 {
 public:  
-	// CAN0
-	int USB2CAN0_;
+	// 第一个适配器, can_transports_ 中的下标
+	int USB2CAN0_ = 0;
 
-	Tangair_usb2can();
+	// config_path 非空时先加载配置, 再按 can_topology (缺省为 can_transport) 创建各适配器的CAN传输层
+	// replay_mode: 传输层固定为回环, 不打开飞行记录器 (避免覆盖待回放的记录文件)
+	explicit Tangair_usb2can(const std::string& config_path = "", bool replay_mode = false);
 	~Tangair_usb2can();
 
 	std::atomic<bool> running_{false};
@@ -143,10 +275,17 @@ public:
 	void startThreadedMeasurement();
     void IMU_Shutdown();
 
+	ImuState GetImuState() const;
+	// 写入一个IMU样本, IMU线程与回放共用
+	void StoreImuSample(const ImuState &imu);
+
 	// DDS 
-	void DDS_Init();
+	// lowcmd_input 为 false 时只建立 lowstate 发布端, 不订阅 LowCmd 也不启动 lowstate 线程 (回放用)
+	void DDS_Init(bool lowcmd_input = true);
 	void LowCmdMessageHandler(const void *messages);
 	void PublishLowState();
+	void PublishLowStateIdle();
+	void LowStatePublishThread();
 
 	// Main control
 	void StartReadLoop();
@@ -154,6 +293,19 @@ public:
 	void StopAllThreads();
 	
     bool LoadConfigFromYAML(const std::string& filepath);
+	void SetupRealtime();
+	// 各环节延迟 (LowCmd -> TX, RX -> LowState), 每行 count 与 p50/p99/p999/max
+	void PrintLatencyStats() const;
+	void ResetLatencyStats();
+	const StageLatencyStats &GetStageLatency() const { return stage_latency_; }
+
+	// 打印实时线程积累的超限报告, 在非实时线程调用
+	void ReportLimitViolations();
+	CommandValidatorStats GetCommandValidatorStats() const { return command_validator_.GetStats(); }
+	CommandInterpolatorStats GetCommandInterpolatorStats() const { return command_interpolator_.GetStats(); }
+
+	// 导出飞行记录器 end_ns (缺省为当前时间) 之前 dump_seconds 秒起的数据, 未启用时返回 false
+	bool DumpFlightRecorder(int64_t end_ns = 0) const;
     bool CheckPositionAndGainValidity(const Matrix3x4d& positions,
                                       const Matrix3x4d& kp_array,
                                       const Matrix3x4d& kd_array);
@@ -165,41 +317,42 @@ public:
 
 	void ResetPositionToZero();
 
-	std::vector<double> GetMotorPositions();
-    std::vector<double> GetMotorVelocity();
-    std::vector<double> GetMotorTorque();
+	MotorStateBlock GetMotorState() const;
+	std::array<float, NUM_MOTOR> GetMotorPositions() const;
+	std::array<float, NUM_MOTOR> GetMotorVelocity() const;
+	std::array<float, NUM_MOTOR> GetMotorTorque() const;
 
 	void UpdateMotorState();
-    std::vector<double> GetMotorFloatVector(const std::string& field);
 
 	std::thread _CAN_TX_position_thread;
 	void CAN_TX_position_thread();
+
+	RtLoopStats GetRtLoopStats() const;
+	void ResetRtLoopStats();
 	
 
-	std::thread _CAN_RX_device_0_thread;
-	void CAN_RX_device_0_thread();
+	// 每个适配器一个RX线程
+	std::vector<std::thread> can_rx_threads_;
+	void CAN_RX_device_thread(int adapter);
+	// timestamp_ns 为 0 时取当前时间
+	void CAN_RX_Decode(uint8_t channel, uint32_t canID, const uint8_t *data, int64_t timestamp_ns = 0, int adapter = 0);
+	// 一次 Receive 取到的整批帧, 各帧 timestamp_ns 为 0 时取当前时间
+	void CAN_RX_DecodeBatch(const CanFrame *frames, int count, int adapter = 0);
+
+	// dds_index 为 DDS 顺序的关节序号
+	MotorReplyStats GetMotorReplyStats(int dds_index) const;
+	void ResetMotorReplyStats();
 
 	/*********************************       ***Motor related***      ***********************************************/
 	// Motor basic param
-	FrameInfo txMsg_CAN = {
-		.canID = 0,
-		.frameType = STANDARD,
-		.dataLength = 8,
-	};
-
-	uint8_t Data_CAN[8];
 	Motor_CAN_Send_Struct Motor_Data_Single;
 
-	// Receive buffer
-	Motor_CAN_Recieve_Struct CAN_DEV0_RX;
+	// 按DDS序号访问各关节的发送结构体与拓扑
+	Motor_CAN_Send_Struct &MotorSend(int dds_index) { return motor_send_[dds_index]; }
+	const JointDescriptor &Joint(int dds_index) const { return joints_[dds_index]; }
+	int NumAdapters() const { return (int)can_transports_.size(); }
 
-	// Data form motor
-	USB2CAN_CAN_Bus_Struct USB2CAN0_CAN_Bus_1; // 模块0，can1
-	USB2CAN_CAN_Bus_Struct USB2CAN0_CAN_Bus_2;  // 模块0，can2
-	
 	// Init
-	void USB2CAN_CAN_Bus_inti_set(USB2CAN_CAN_Bus_Struct* Leg_Data);
-
 	void USB2CAN_CAN_Bus_Init();
 
 	void Motor_Enable(int32_t dev, uint8_t channel, Motor_CAN_Send_Struct *Motor_Data);
@@ -208,37 +361,175 @@ public:
 
 	void Motor_Zore(int32_t dev, uint8_t channel, Motor_CAN_Send_Struct *Motor_Data);
 
+	void CAN_Send_Frame(int32_t dev, uint8_t channel, uint32_t can_id, const uint8_t *data);
 	void CAN_Send_Control(int32_t dev, uint8_t channel, Motor_CAN_Send_Struct *Motor_Data); // 运控�??,CAN1=CAN_TX_MAILBOX0,CAN2=CAN_TX_MAILBOX1
 
 	void Motor_Passive_SET(int32_t dev, uint8_t channel, Motor_CAN_Send_Struct *Motor_Data);
 
-	void ENABLE_ALL_MOTOR(int delay_us);
+	// 各总线并行发送, 每个电机等待反馈确认, 超时重发; 同一路can上相邻两帧至少间隔 max(delay_us, CAN_FRAME_TIME_US)
+	MotorSequenceResult ENABLE_ALL_MOTOR(int delay_us);
+
+	MotorSequenceResult DISABLE_ALL_MOTOR(int delay_us);
 
-	void DISABLE_ALL_MOTOR(int delay_us);
+	MotorSequenceResult ZERO_ALL_MOTOR(int delay_us);
 
-	void ZERO_ALL_MOTOR(int delay_us);
+	MotorSequenceResult PASSIVE_ALL_MOTOR(int delay_us);
 
-	void PASSIVE_ALL_MOTOR(int delay_us);
+	// 一行汇总, 失败的电机逐个打印
+	void PrintMotorSequenceResult(const char *name, const MotorSequenceResult &result) const;
 
 	void CAN_TX_ALL_MOTOR(int delay_us);
+	// 关闭后 CAN_TX_ALL_MOTOR 不再按总线占用时间等待 (回放的最快模式)
+	void SetTxPacing(bool enabled) { tx_pacing_ = enabled; }
 
+	// 实时循环每拍的 指令 -> 发送 -> 发布 部分, 回放按记录的周期调用
+	void ControlStep(bool publish);
 
-private:
-	int num_motor_ = 12; // ex: 12
+	CanTransport &GetCanTransport(int dev) { return *can_transports_[dev]; }
+	// TX调度表第 i 个槽位, 每周期按槽位顺序发送
+	const CAN_TX_Slot_Struct &GetTxSlot(int i) const { return tx_schedule_[i]; }
 
-	struct MotorState {
-		std::vector<double> position;
-		std::vector<double> velocity;  // 20個 0
-		std::vector<double> torque;
-	};
+	TxCycleStats GetTxCycleStats();
+	void ResetTxCycleStats();
 
-    MotorState motor_state_;         
-    std::mutex motor_state_mutex;    
 
-	std::vector<double> dof_pos;
-	Matrix3x4d kp_array_;
-	Matrix3x4d kd_array_;
-	Matrix3x4d real_angles_;
+private:
+	int num_motor_ = NUM_MOTOR; // ex: 12
+
+	// CAN传输层, 每个适配器一个, 下标即各函数的 dev 参数
+	CanTransportConfig can_transport_config_;
+	CanTopologyConfig can_topology_config_;
+	std::vector<std::unique_ptr<CanTransport>> can_transports_;
+
+	// 运行时关节表与各关节的收发结构体, 均按DDS序号排列
+	std::array<JointDescriptor, NUM_MOTOR> joints_ = JOINT_MAP;
+	std::array<Motor_CAN_Send_Struct, NUM_MOTOR> motor_send_{};
+	std::array<Motor_CAN_Recieve_Struct, NUM_MOTOR> motor_recv_{};
+	// 本总线上依次发送的关节, 各总线按序交替排入 tx_schedule_
+	std::vector<std::vector<int>> bus_joint_order_;
+	// 由 can_topology 生成关节表, 配置无效时打印原因并退回默认拓扑
+	void BuildCanTopology();
+
+	// 实时控制循环
+	static constexpr int kMinControlRateHz = 500;
+	static constexpr int kMaxControlRateHz = 2000;
+	RealtimeConfig realtime_config_;
+	size_t PrefaultStackBytes() const;
+	std::atomic<bool> rt_loop_active_{false};
+	// 实时循环到发布拍时写 lowstate_fd_, 由 LowStatePublishThread 完成 DDS 序列化与发送;
+	// 该线程未启动时 (回放) 在 ControlStep 内直接发布; 周期 lowstate 线程只在实时循环之外发布
+	int lowstate_fd_ = -1;
+	std::thread lowstate_pub_thread_;
+	std::atomic<bool> lowstate_thread_active_{false};
+	std::atomic<uint64_t> rt_cycles_{0};
+	std::atomic<uint64_t> rt_overruns_{0};
+	std::atomic<uint64_t> rt_missed_ticks_{0};
+	LatencyHistogram rt_jitter_;
+	LatencyHistogram rt_exec_;
+
+	// TX调度表, 各总线交替排列, 按总线占用时间节拍发送
+	static constexpr int kNumTxSlots = 12;
+	static constexpr int kMaxChannels = 4; // 每个适配器的通道号 1 ~ kMaxChannels
+	using BusFreeTimes = std::array<std::chrono::steady_clock::time_point, kMaxChannels + 1>;
+	std::array<CAN_TX_Slot_Struct, kNumTxSlots> tx_schedule_;
+	std::vector<BusFreeTimes> bus_free_time_; // [adapter][channel]
+	bool tx_pacing_ = true;
+	void CAN_TX_Schedule_Init();
+	// 按节拍发送 adapter 上的各槽位, payload 为第 cycle 个TX周期的整批负载
+	void CAN_TX_Adapter(int adapter, const uint8_t (*payload)[8], uint32_t cycle, int delay_us);
+
+	// 整周期批量编码, 批内序号即 tx_schedule_ 槽位, 仅实时循环使用
+	static_assert(kNumTxSlots == kMitBatchSize, "TX schedule must match the MIT batch size");
+	MitBatchCodec tx_codec_;
+	MitCommandBatch tx_batch_;
+	alignas(16) uint8_t tx_payload_[kNumTxSlots][8];
+
+	// 第2个及以后适配器的TX线程, 实时循环编码后经 eventfd 唤醒
+	// 负载经 SeqLock 交给TX线程, 各线程取一份完整副本再发送, 落后的线程不会读到被下一周期改写的负载
+	struct TxWorkerCycle
+	{
+		uint32_t cycle;
+		int32_t delay_us;
+		uint8_t payload[kNumTxSlots][8];
+	};
+	std::vector<std::thread> can_tx_threads_;
+	std::vector<int> tx_worker_fd_;				  // 下标为适配器, 第1个不用
+	SeqLock<TxWorkerCycle> tx_worker_cycle_;
+	std::atomic<bool> tx_workers_active_{false};
+	std::atomic<uint64_t> tx_worker_skipped_{0};  // TX线程来不及发送而跳过的周期
+	void CAN_TX_worker_thread(int adapter);
+
+	// RX解码表, [adapter][channel][canID & 0x0F], 反馈ID为 0x10 | 电机ID, 未知帧的表项 joint 为 -1, 不解码
+	static constexpr int kNumRxIds = 16;
+	using RxDecodeTable = std::array<std::array<CAN_RX_Decode_Struct, kNumRxIds>, kMaxChannels + 1>;
+	std::vector<RxDecodeTable> rx_decode_table_;
+	void CAN_RX_Decode_Init();
+
+	// 反馈时效, 以下数组均按DDS序号排列
+	// TX线程每周期递增周期号并记录各帧发出时间 (带所属周期号), RX线程据此标记样本所属周期,
+	// 各适配器的12路到齐时通过 rx_complete_fd_ 唤醒实时循环立即生成快照 (整机的周期屏障)
+	static constexpr uint32_t kAllJointsMask = (1u << NUM_MOTOR) - 1;
+	std::array<int8_t, kNumTxSlots> tx_slot_joint_;
+	std::atomic<uint32_t> tx_cycle_seq_{0};
+	struct TxSentStamp
+	{
+		uint32_t cycle;
+		int64_t sent_ns;
+	};
+	std::array<SeqLock<TxSentStamp>, NUM_MOTOR> tx_sent_; // 每个关节只由发送其适配器的线程写入
+	std::array<std::atomic<uint32_t>, NUM_MOTOR> rx_cycle_{};
+	std::array<std::atomic<int64_t>, NUM_MOTOR> rx_time_ns_{};
+	std::array<std::atomic<uint64_t>, NUM_MOTOR> rx_replies_{};
+	std::array<std::atomic<uint64_t>, NUM_MOTOR> rx_missed_{};
+	std::array<std::atomic<uint32_t>, NUM_MOTOR> rx_ack_seq_{};	// 每收到一帧反馈加1, 不随统计清零
+	std::array<std::atomic<uint8_t>, NUM_MOTOR> rx_state_{};	// 最近一帧反馈的状态码
+	std::array<LatencyHistogram, NUM_MOTOR> rx_latency_;
+	std::atomic<uint32_t> rx_pending_mask_{0};
+	int rx_complete_fd_ = -1;
+
+	// 使能等序列: 等待 reply_wait_mask_ 中的电机应答, 其反馈解码后经 reply_fd_ 唤醒
+	// rx_serviced_mask_ 按适配器记录是否有 RX 线程或 io_reactor 在接收, 没有时序列在本线程直接接收
+	enum class MotorCommand : uint8_t { kEnable, kDisable, kZero, kPassive };
+	MotorSequenceConfig motor_sequence_config_;
+	std::mutex motor_sequence_mutex_;
+	std::atomic<uint32_t> reply_wait_mask_{0};
+	std::atomic<uint32_t> rx_serviced_mask_{0};
+	int reply_fd_ = -1;
+	MotorSequenceResult RunMotorSequence(MotorCommand command, uint32_t joint_mask, int delay_us);
+	void SendMotorCommand(MotorCommand command, const CAN_TX_Slot_Struct &tx);
+	void WaitMotorReplies(uint32_t pending, int64_t timeout_ns);
+
+	// 各环节延迟统计
+	LatencyStatsConfig latency_stats_config_;
+	StageLatencyStats stage_latency_;
+
+	// 飞行记录器, 记录TX/RX帧、LowCmd 与 IMU 样本
+	FlightRecorderConfig flight_recorder_config_;
+	FlightRecorder flight_recorder_;
+
+	std::chrono::steady_clock::time_point last_tx_cycle_start_;
+	std::atomic<int64_t> tx_cycle_last_ns_{0};
+	std::atomic<int64_t> tx_cycle_min_ns_{0};
+	std::atomic<int64_t> tx_cycle_max_ns_{0};
+	std::atomic<int64_t> tx_cycle_total_ns_{0};
+	std::atomic<uint64_t> tx_cycle_count_{0};
+
+	// TX线程写, DDS线程读, 读端不会阻塞TX线程
+	SeqLock<MotorStateBlock> motor_state_;
+	// RX解码写, UpdateMotorState 读; 每个关节同一时刻只有一个接收线程 (RX线程 / io_reactor / 序列内接收)
+	std::array<SeqLock<JointFeedback>, NUM_MOTOR> joint_feedback_;
+
+	// DDS线程写, 实时循环每周期取一次完整指令; lowcmd_seq_ 仅DDS线程使用, tx_cmd_seq_ 为已发出的最近一条
+	SeqLock<LowCmdBlock> lowcmd_;
+	uint64_t lowcmd_seq_ = 0;
+	uint64_t tx_cmd_seq_ = 0;
+	// 最近一条通过校验并进入插值的指令的增益, 仅实时循环使用
+	std::array<double, NUM_MOTOR> active_kp_{};
+	std::array<double, NUM_MOTOR> active_kd_{};
+
+	// 指令插值, 仅实时循环使用
+	CommandInterpolationConfig interpolation_config_;
+	CommandInterpolator command_interpolator_;
 
     unitree_go::msg::dds_::LowCmd_ low_cmd{};
 
@@ -247,10 +538,38 @@ private:
     /*subscriber*/
     ChannelSubscriberPtr<unitree_go::msg::dds_::LowCmd_> lowcmd_subscriber;
 
+	// IMU线程写, DDS线程读
+	SeqLock<ImuState> imu_state_;
+	int64_t imu_published_ns_ = 0;	// 上一次 LowState 中 IMU 样本的时间, 仅发布线程使用
+
+	// 取出回调缓冲中的全部样本并发布, 由 IMU 线程或 io_reactor 线程调用 (二者只启用其一)
+	bool StartImuMeasurement();
+	void DrainImuPackets();
+	XsDataPacket imu_packet_;
+	ImuState imu_work_{};
+
+	// 单线程 I/O (realtime.io_reactor): 首次启动 IMU 或 CAN 接收时创建, 析构时停止
+	// 登记可 poll 的适配器、IMU 回调的 eventfd 与 1 Hz 统计 timerfd, 解码在本线程内完成
+	IoReactor io_reactor_;
+	std::thread io_reactor_thread_;
+	std::vector<uint8_t> adapter_polled_;	   // 下标为适配器, 为 1 时由 io_reactor 接收, 不再启动 can_rx 线程
+	std::vector<int> io_rx_count_;			   // 仅 io_reactor 线程使用
+	std::vector<int> io_rx_reads_;
+	int io_rate_fd_ = -1;
+	bool StartIoReactor();
+	void StopIoReactor();
+	void IoReactorThread();
+	void DrainCanAdapter(int adapter);
+	void PrintIoReactorRate();
+	int AdapterJointCount(int adapter) const;
+	void PrintRxRate(int adapter, int frames, int reads) const;
+	static constexpr int kRxBatch = 64;		   // 每次 Receive 最多取的帧数
+
     /*LowCmd write thread*/
     ThreadPtr lowStatePuberThreadPtr;
     ControlLimits control_limits_;
     LegJointLimitsMap joint_limits_per_leg_;  // ✅ 這一行最重要
+	CommandValidator command_validator_;	  // 由上面两项展开的扁平限位表
 };
 
 #endif
@@ -8,8 +8,7 @@
 #include <xstypes/xsdatapacket.h>
 
 #include <xstypes/xstime.h>
-#include <xscommon/xsens_mutex.h>
-#include <list>
+#include "spsc_ring.h"
 
 struct SensorData {
     XsVector acc;
@@ -24,23 +23,52 @@ struct SensorData {
 
 bool isSensorDataValid(const SensorData& data); 
 
+// 跨執行緒共享的 IMU 狀態, 定長 POD, 經 SeqLock 發布
+struct ImuState {
+    float quat[4];          // w, x, y, z
+    float gyr[3];
+    float acc[3];
+    float mag[3];
+    int64_t timestamp_ns;   // 回調收到樣本的 CLOCK_MONOTONIC 時間
+    uint32_t packet_counter;
+};
+
 class CallbackHandler : public XsCallback
 {
 public:
-    CallbackHandler(size_t maxBufferSize = 5);
+    static constexpr size_t kPacketBufferSize = 8;
+
+    CallbackHandler();
     virtual ~CallbackHandler() throw();
 
     bool packetAvailable() const;
     XsDataPacket getNextPacket();
+    // arrival_ns: 回调收到该样本时的 CLOCK_MONOTONIC 时间
+    bool tryGetNextPacket(XsDataPacket& packet, int64_t* arrival_ns = nullptr);
+
+    // 阻塞等待新样本, 由回调通过 eventfd 唤醒, 超时返回 false
+    bool waitForPacket(int timeout_ms);
+    int eventFd() const;
+    // 外部 poll/epoll 到 eventFd 可读後調用, 先清除計數再取樣本, 不會漏掉新樣本
+    void acknowledgeEvent();
+
+    // 缓冲满时被覆盖的样本数
+    uint64_t droppedPackets() const;
 
 protected:
     virtual void onLiveDataAvailable(XsDevice*, const XsDataPacket* packet);
 
 private:
-    mutable xsens::Mutex m_mutex;
-    size_t m_maxNumberOfPacketsInBuffer;
-    size_t m_numberOfPacketsInBuffer;
-    std::list<XsDataPacket> m_packetBuffer;
+    struct TimedPacket {
+        XsDataPacket packet;
+        int64_t arrival_ns = 0;
+    };
+
+    // XDA 解析线程写入, 测量线程读取
+    SpscRing<TimedPacket, kPacketBufferSize> m_packetBuffer;
+    TimedPacket m_popped;
+    TimedPacket m_pushed;
+    int m_eventFd;
 };
 
 
@@ -0,0 +1,134 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef CAN_TRANSPORT_H
+#define CAN_TRANSPORT_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "config_loader.h"
+
+// 一帧CAN数据, channel 从1开始 (can1, can2, ...)
+struct CanFrame
+{
+	uint8_t channel;
+	uint32_t can_id;
+	uint8_t dlc;
+	uint8_t data[8];
+	int64_t timestamp_ns;	 // 接收时的 CLOCK_MONOTONIC 时间 (有内核时间戳时取内核收到的时刻), 发送帧忽略
+	int64_t hw_timestamp_ns; // 适配器硬件时间戳, 时钟由硬件决定, 不支持时为 0
+};
+
+// CAN传输层抽象: 一个适配器上的若干路CAN
+class CanTransport
+{
+public:
+	virtual ~CanTransport() = default;
+
+	virtual bool Open() = 0;
+	virtual void Close() = 0;
+	virtual const char *Name() const = 0;
+
+	// 返回实际发送的帧数, 出错返回 -1
+	virtual int Send(const CanFrame *frames, int count) = 0;
+
+	// 批量接收: 无数据时最多阻塞 timeout_us, 有数据后不再等待, 一次取走已缓存的全部帧 (最多 max_frames)
+	// 返回帧数, 超时返回 0, 出错返回 -1; timeout_us = 0 时不阻塞
+	virtual int Receive(CanFrame *frames, int max_frames, int timeout_us) = 0;
+
+	// 可读时 Receive(..., 0) 即可取到数据的描述符, 供 epoll 使用; 为空表示只能阻塞接收
+	virtual std::vector<int> PollFds() const { return {}; }
+};
+
+// 达妙 USB2CAN 模块, 通过 libusb_can 的 sendUSBCAN/readUSBCAN 逐帧收发
+// openUSBCAN 返回的设备号即串口的非阻塞 fd, 可直接登记到 epoll
+// readUSBCAN 每次只取一帧, 帧内只做一次 16 字节的非阻塞 read, 读到半帧时校验失败并丢掉已读字节;
+// Receive 先在 poll 上睡眠等待数据, 串口缓冲中够一整帧才调用 readUSBCAN, 每帧在读出时取时间
+class Usb2CanTransport : public CanTransport
+{
+public:
+	static constexpr int kFrameBytes = 16;
+	// 已有字节到达后等齐一整帧的上限
+	static constexpr int kFrameReadTimeoutUs = 1000;
+
+	explicit Usb2CanTransport(const std::string &device);
+	~Usb2CanTransport() override;
+
+	bool Open() override;
+	void Close() override;
+	const char *Name() const override { return "usb2can"; }
+	int Send(const CanFrame *frames, int count) override;
+	int Receive(CanFrame *frames, int max_frames, int timeout_us) override;
+	std::vector<int> PollFds() const override;
+
+private:
+	bool WaitFrameBytes(int timeout_us) const;
+
+	std::string device_;
+	int32_t dev_ = -1;
+};
+
+// Linux SocketCAN, interfaces[i] 对应 channel i+1, 使用 sendmmsg/recvmmsg 批量收发
+// 开启 SO_TIMESTAMPING, 每帧取内核接收时间 (换算到 CLOCK_MONOTONIC) 与网卡支持时的硬件时间
+class SocketCanTransport : public CanTransport
+{
+public:
+	static constexpr int kMaxBatch = 64;
+
+	explicit SocketCanTransport(const std::vector<std::string> &interfaces);
+	~SocketCanTransport() override;
+
+	bool Open() override;
+	void Close() override;
+	const char *Name() const override { return "socketcan"; }
+	int Send(const CanFrame *frames, int count) override;
+	int Receive(CanFrame *frames, int max_frames, int timeout_us) override;
+	std::vector<int> PollFds() const override { return sockets_; }
+
+private:
+	std::vector<std::string> interfaces_;
+	std::vector<int> sockets_;
+};
+
+// 进程内回环: 发送的帧交给 responder (如电机仿真), 没有 responder 时原样回送
+// 用于无硬件的基准测试; 队列非空时 event_fd_ 可读
+class LoopbackCanTransport : public CanTransport
+{
+public:
+	static constexpr size_t kQueueSize = 1024;
+	using Responder = std::function<void(const CanFrame &tx, LoopbackCanTransport &bus)>;
+
+	LoopbackCanTransport();
+	~LoopbackCanTransport() override;
+
+	bool Open() override { return true; }
+	void Close() override {}
+	const char *Name() const override { return "loopback"; }
+	int Send(const CanFrame *frames, int count) override;
+	int Receive(CanFrame *frames, int max_frames, int timeout_us) override;
+	std::vector<int> PollFds() const override;
+
+	void SetResponder(Responder responder);
+	// 放入一帧待接收数据, 队列满时丢弃
+	bool Inject(const CanFrame &frame);
+
+private:
+	Responder responder_;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::array<CanFrame, kQueueSize> queue_;
+	size_t head_ = 0;
+	size_t tail_ = 0;
+	int event_fd_ = -1;
+};
+
+// 按 config.type 创建, 未知类型退回 usb2can
+std::unique_ptr<CanTransport> CreateCanTransport(const CanTransportConfig &config);
+
+#endif // CAN_TRANSPORT_H
@@ -0,0 +1,73 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef COMMAND_INTERPOLATOR_H
+#define COMMAND_INTERPOLATOR_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "command_validator.h"
+#include "config_loader.h"
+
+// LowCmd (50 ~ 200 Hz) 与 CAN 周期 (500 ~ 2000 Hz) 之间的插值, 只在实时循环中使用
+// 收到新指令时以当前设定值为起点、新指令为终点建立一段轨迹, 时长为估计的指令间隔;
+// 指令迟到时沿末端速度外推, 最多 extrapolate_ms, 之后保持
+// 数组均为 Matrix3x4d 列优先顺序 (见 command_validator.h), 只插值位置, kp / kd 随指令直接切换
+struct CommandInterpolatorStats
+{
+	uint64_t commands;
+	uint64_t rejected;	   // 含 NaN / Inf 而丢弃的指令
+	uint64_t samples;
+	uint64_t extrapolated; // 指令已迟到, 处于外推段的周期数
+	uint64_t held;		   // 超过外推上限, 保持不动的周期数
+	int64_t interval_ns;   // 当前估计的指令间隔
+};
+
+class CommandInterpolator
+{
+public:
+	// control_period_ns 为实时循环周期, 作为指令间隔估计的下限
+	void Configure(const CommandInterpolationConfig &config, int64_t control_period_ns);
+	InterpolationMode Mode() const { return config_.mode; }
+
+	// 新指令, velocity 仅 cubic 使用; start_ns 为本段轨迹的起点 (取当前周期时间)
+	// 位置 (cubic 时含速度) 出现 NaN / Inf 时丢弃整条并返回 false, 当前轨迹不受影响
+	bool Push(const double *position, const double *velocity, int64_t arrival_ns, int64_t start_ns);
+
+	// now_ns 时刻的设定值, 未收到指令前返回 false
+	bool Sample(int64_t now_ns, double *position);
+
+	void Reset();
+	CommandInterpolatorStats GetStats() const;
+
+private:
+	CommandInterpolationConfig config_;
+	int64_t min_interval_ns_ = 1000000;
+	int64_t max_interval_ns_ = 50000000;
+	int64_t extrapolate_ns_ = 20000000;
+
+	bool primed_ = false;
+	int64_t last_arrival_ns_ = 0;
+	int64_t interval_ns_ = 0;
+
+	// 当前段: [start_ns_, start_ns_ + duration_ns_] 内从 p0 / v0 到 p1 / v1
+	int64_t start_ns_ = 0;
+	int64_t duration_ns_ = 0;
+	double p0_[kNumCommandJoints] = {};
+	double v0_[kNumCommandJoints] = {};
+	double p1_[kNumCommandJoints] = {};
+	double v1_[kNumCommandJoints] = {};
+
+	// 上一次输出, 作为下一段的起点
+	double out_p_[kNumCommandJoints] = {};
+	double out_v_[kNumCommandJoints] = {};
+
+	std::atomic<uint64_t> commands_{0};
+	std::atomic<uint64_t> rejected_{0};
+	std::atomic<uint64_t> samples_{0};
+	std::atomic<uint64_t> extrapolated_{0};
+	std::atomic<uint64_t> held_{0};
+	std::atomic<int64_t> interval_stat_ns_{0};
+};
+
+#endif // COMMAND_INTERPOLATOR_H
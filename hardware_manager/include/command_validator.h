@@ -0,0 +1,97 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef COMMAND_VALIDATOR_H
+#define COMMAND_VALIDATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+#include "config_loader.h"
+#include "spsc_ring.h"
+
+// 3x4 关节指令 (位置 / kp / kd) 的限位校验
+// 输入为 Matrix3x4d 的列优先存储: 下标 i = col * 3 + row, row 0 小腿 / 1 大腿 / 2 髋, col 为 FR FL RR RL
+// 限位在加载配置时展开为扁平数组, 校验为无分支的 SIMD 比较, 结果为每个字段一个12位掩码
+constexpr int kNumCommandJoints = 12;
+
+struct LimitViolation
+{
+	uint16_t position = 0; // 第 i 位: 第 i 个关节超限 (含 NaN / Inf)
+	uint16_t kp = 0;
+	uint16_t kd = 0;
+	uint16_t non_finite = 0; // 三个字段中任一为 NaN / Inf
+
+	bool any() const { return (position | kp | kd) != 0; }
+	bool operator==(const LimitViolation &o) const
+	{
+		return position == o.position && kp == o.kp && kd == o.kd && non_finite == o.non_finite;
+	}
+};
+
+// 实时线程写入, 非实时线程取出打印
+struct LimitViolationReport
+{
+	int64_t t_ns;
+	LimitViolation violation;
+	bool rejected;
+	uint8_t field; // 第一个超限项: 0 position, 1 kp, 2 kd
+	uint8_t index; // 第一个超限项的关节下标
+	double value;
+	double min;
+	double max;
+};
+
+struct CommandValidatorStats
+{
+	uint64_t checked;
+	uint64_t rejected;		  // 整条丢弃的指令
+	uint64_t clamped;		  // 限幅后发送的指令
+	uint64_t clamped_values;  // 被限幅的数值个数
+	uint64_t reports_dropped; // 报告队列满时丢弃的条数
+};
+
+class CommandValidator
+{
+public:
+	// 未设置限位前所有指令都不通过
+	CommandValidator();
+
+	void SetLimits(const ControlLimits &control, const LegJointLimitsMap &joints);
+	LimitViolationMode Mode() const { return mode_; }
+
+	// 只比较, 无副作用
+	LimitViolation Check(const double *position, const double *kp, const double *kd) const;
+
+	// 校验并按模式处理: 通过或限幅后返回 true (clamp 模式会原地修改输入), 丢弃时返回 false
+	// 出现超限时写入一条报告, 不打印
+	bool Apply(double *position, double *kp, double *kd);
+
+	// 消费端 (单线程): 取出报告打印, 连续相同的超限合并为一行
+	void DrainReports(std::ostream &os);
+
+	CommandValidatorStats GetStats() const;
+
+private:
+	struct Limits
+	{
+		alignas(16) double min[kNumCommandJoints];
+		alignas(16) double max[kNumCommandJoints];
+	};
+
+	Limits position_, kp_, kd_;
+	LimitViolationMode mode_ = LimitViolationMode::kReject;
+
+	std::atomic<uint64_t> checked_{0};
+	std::atomic<uint64_t> rejected_{0};
+	std::atomic<uint64_t> clamped_{0};
+	std::atomic<uint64_t> clamped_values_{0};
+
+	SpscRing<LimitViolationReport, 64> reports_;
+
+	// 仅消费端使用
+	LimitViolation last_reported_;
+	uint64_t repeats_ = 0;
+};
+
+#endif // COMMAND_VALIDATOR_H
@@ -1,10 +1,18 @@
 #pragma once
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+// 指令超限时的处理: reject 整条指令丢弃; clamp 限幅到范围内并计数 (非有限值仍整条丢弃)
+enum class LimitViolationMode {
+    kReject,
+    kClamp,
+};
 
 struct ControlLimits {
     double kp_min, kp_max;
     double kd_min, kd_max;
+    LimitViolationMode violation_mode = LimitViolationMode::kReject;
 };
 
 struct JointLimit {
@@ -17,4 +25,115 @@ struct JointLimits {
     JointLimit calf;
 };
 
+// 单个线程的CPU绑定与 SCHED_FIFO 优先级, cpu = -1 不绑定, priority = 0 为 SCHED_OTHER
+struct ThreadRtConfig {
+    int cpu = -1;
+    int priority = 0;
+};
+
+// 实时控制循环: timerfd 驱动, 每周期 读状态 -> 指令 -> 发送 -> 发布
+struct ControlLoopConfig {
+    int rate_hz = 1000;        // 500 ~ 2000
+    int publish_divider = 2;   // 每 N 个周期发布一次 LowState
+    ThreadRtConfig thread{-1, 80};
+};
+
+// 单线程 I/O: 一个 epoll 线程处理所有可 poll 的CAN适配器与 IMU 样本, 代替各自的 can_rx / imu 线程
+// 没有可 poll 描述符的适配器 (如未打开的设备) 仍使用 can_rx 线程
+struct IoReactorConfig {
+    bool enabled = false;
+    ThreadRtConfig thread{-1, 85};
+};
+
+struct RealtimeConfig {
+    bool lock_memory = true;
+    int prefault_stack_kb = 256;
+    ControlLoopConfig control_loop;
+    ThreadRtConfig can_rx;     // 每个适配器一个RX线程, 共用此设置
+    ThreadRtConfig can_tx;     // 第2个及以后适配器的TX线程, 第1个由实时循环直接发送
+    ThreadRtConfig imu;
+    ThreadRtConfig lowstate;
+    ThreadRtConfig xda;        // XDA DataPoller / DataParser
+    IoReactorConfig io_reactor;
+};
+
+// 电机总线仿真 (can_transport.type = emulator)
+struct CanEmulatorConfig {
+    int latency_us = 200;      // 发送到反馈的固定延迟
+    int jitter_us = 50;        // 延迟上叠加的均匀抖动 [0, jitter_us]
+    double loss_rate = 0.0;    // 反馈帧丢失概率 0 ~ 1
+    int bitrate = 1000000;     // 用于计算每帧占用总线的时间
+    double inertia = 0.02;     // 关节等效转动惯量 kg*m^2
+    double damping = 0.05;     // 关节粘滞阻尼 N*m*s/rad
+    unsigned seed = 1;
+};
+
+// CAN传输层: usb2can / socketcan / loopback / emulator
+struct CanTransportConfig {
+    std::string type = "usb2can";
+    std::string device = "/dev/ttyRedDog";                   // usb2can
+    std::vector<std::string> interfaces = {"can0", "can1"};  // socketcan, 依次对应 channel 1, 2
+    CanEmulatorConfig emulator;
+};
+
+// 总线上的一个电机: CAN ID (1~15), 型号 DM8006 / DM8009, DDS 关节序号, 反馈方向
+struct CanMotorConfig {
+    int id = 0;
+    std::string type = "DM8006";
+    int joint = -1;
+    float sign = 1.0f;
+};
+
+// 一路CAN总线: 所在适配器 (can_topology.adapters 下标) 与通道号, motors 为本总线的发送顺序
+struct CanBusConfig {
+    int adapter = 0;
+    int channel = 1;
+    std::vector<CanMotorConfig> motors;
+};
+
+// 总线拓扑, 为空时使用单适配器 (can_transport) 上两路can的默认布局
+struct CanTopologyConfig {
+    std::vector<CanTransportConfig> adapters;
+    std::vector<CanBusConfig> buses;
+};
+
+// 飞行记录器: mmap 环形文件, 各类事件各占一个环, records 为环的容量 (向上取整到2的幂)
+struct FlightRecorderConfig {
+    bool enabled = false;
+    std::string path = "/tmp/reddog_flight.bin";
+    std::string dump_path = "/tmp/reddog_flight_dump.bin";  // SIGINT / 崩溃时导出最近 dump_seconds 秒
+    double dump_seconds = 10.0;
+    int tx_records = 262144;
+    int rx_records = 262144;
+    int lowcmd_records = 65536;
+    int imu_records = 65536;
+};
+
+// 使能 / 失能 / 置零 / 阻尼序列: 各总线并行发送, 等待每个电机的反馈, 超时后只向未应答的电机重发
+struct MotorSequenceConfig {
+    int reply_timeout_us = 5000;   // 每次发送后等待反馈的时间
+    int retries = 3;               // 超时后的重发次数
+};
+
+// 各环节延迟统计, shared_memory 为 true 时放在 POSIX 共享内存中, 可用 reddog_stats 在线读取
+struct LatencyStatsConfig {
+    bool shared_memory = true;
+    std::string shm_name = "/reddog_latency";
+};
+
+// LowCmd 到 CAN 周期之间的插值: hold 每周期重发最近一条指令 (原行为);
+// linear / cubic (Hermite, 端点速度取 LowCmd 的 dq) / min_jerk 在一个指令间隔内从当前设定值平滑过渡到新指令
+enum class InterpolationMode {
+    kHold,
+    kLinear,
+    kCubic,
+    kMinJerk,
+};
+
+struct CommandInterpolationConfig {
+    InterpolationMode mode = InterpolationMode::kHold;
+    double extrapolate_ms = 20.0;   // 指令迟到时沿末端速度外推的最长时间, 之后保持
+    double max_interval_ms = 50.0;  // 指令间隔估计的上限, 超过视为指令流中断
+};
+
 using LegJointLimitsMap = std::unordered_map<std::string, JointLimits>;
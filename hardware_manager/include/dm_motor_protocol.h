@@ -0,0 +1,58 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef DM_MOTOR_PROTOCOL_H
+#define DM_MOTOR_PROTOCOL_H
+
+// 达妙电机 MIT 模式协议参数, 主程序与电机仿真共用
+
+//达妙其他电机参数    {P, V, T}
+				// {12.5, 30, 10 }, // DM4310
+				// {12.5, 50, 10 }, // DM4310_48V
+				// {12.5, 8, 28 },  // DM4340
+				// {12.5, 10, 28 }, // DM4340_48V
+				// {12.5, 45, 20 }, // DM6006
+				// {12.5, 45, 40 }, // DM8006
+				// {12.5, 45, 54 }, // DM8009
+				// {12.5,25,  200}, // DM10010L
+				// {12.5,20, 200},  // DM10010
+				// {12.5,280,1},    // DMH3510
+				// {12.5,45,10},    // DMH6215
+				// {12.5,45,10}     // DMG6220
+
+// 达妙电机,此处为DM8006参数
+#define P_MIN -12.5f
+#define P_MAX 12.5f
+#define V_MIN -45.0f
+#define V_MAX 45.0f
+#define T_MIN_8006 -40.0f
+#define T_MAX_8006 40.0f
+#define T_MIN_8009 -54.0f
+#define T_MAX_8009 54.0f
+#define KP_MIN 0.0f
+#define KP_MAX 500.0f
+#define KD_MIN 0.0f
+#define KD_MAX 5.0f
+
+// CAN总线参数: 1Mbps, 8字节标准帧最坏位填充约135bit
+constexpr int CAN_BITRATE = 1000000;
+constexpr int CAN_FRAME_BITS_MAX = 135;
+constexpr int CAN_FRAME_TIME_US = CAN_FRAME_BITS_MAX * 1000000 / CAN_BITRATE;
+
+// 反馈帧解码比例, 等价于 uint_to_float 的 span / ((1 << bits) - 1)
+constexpr float P_SCALE_RX = (P_MAX - P_MIN) / 65535.0f;
+constexpr float V_SCALE_RX = (V_MAX - V_MIN) / 4095.0f;
+
+// 特殊指令帧: 前7字节 0xFF, 最后一字节区分
+#define DM_CMD_ENABLE 0xFC
+#define DM_CMD_DISABLE 0xFD
+#define DM_CMD_ZERO 0xFE
+
+// 反馈帧ID = 0x10 | 电机ID
+#define DM_FEEDBACK_ID_BASE 0x10
+
+// 反馈帧 data[0] 高4位的状态码, 8 及以上为故障 (过压、欠压、过流、MOS过温、线圈过温、通讯丢失、过载)
+#define DM_STATE_DISABLED 0x0
+#define DM_STATE_ENABLED 0x1
+#define DM_STATE_FAULT_MIN 0x8
+
+#endif // DM_MOTOR_PROTOCOL_H
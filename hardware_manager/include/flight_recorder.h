@@ -0,0 +1,145 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "config_loader.h"
+
+// 常驻的二进制飞行记录器
+// 预分配并预取的 mmap 文件, 每类事件一个环, 满时覆盖最旧记录
+// 写入端: fetch_add 领取槽位后写记录, 最后以 release 写入序号, 不加锁、不分配、不进内核
+// 读取端 (导出或离线解码): 按序号校验记录, 写到一半的记录会被跳过
+
+constexpr char kFlightMagic[8] = {'R', 'D', 'F', 'L', 'T', 'R', 'E', 'C'};
+constexpr uint32_t kFlightVersion = 1;
+constexpr size_t kFlightHeaderSize = 4096;
+constexpr size_t kFlightPayloadSize = 48;
+
+enum FlightStream : uint8_t
+{
+	kFlightStreamTx = 0,
+	kFlightStreamRx,
+	kFlightStreamLowCmd,
+	kFlightStreamImu,
+	kFlightNumStreams
+};
+
+enum FlightRecordType : uint8_t
+{
+	kFlightRecordTxFrame = 1, // payload: 8 字节数据 + dlc
+	kFlightRecordRxFrame,
+	kFlightRecordLowCmdQ,  // payload: 12 x float
+	kFlightRecordLowCmdKp,
+	kFlightRecordLowCmdKd,
+	kFlightRecordImu, // payload: quat[4], gyr[3], acc[3] float + packet_counter uint32
+};
+
+// 一条记录占一个缓存行
+struct alignas(64) FlightRecord
+{
+	int64_t t_ns;	 // CLOCK_MONOTONIC
+	std::atomic<uint32_t> seq; // 槽位序号 + 1, 0 表示正在写
+	uint16_t id;	 // CAN ID
+	uint8_t type;	 // FlightRecordType
+	uint8_t channel; // CAN 通道, 见 FlightChannel
+	uint8_t payload[kFlightPayloadSize];
+};
+static_assert(sizeof(FlightRecord) == 64, "FlightRecord must be one cache line");
+
+// CAN 帧记录的通道字段: 高4位为适配器序号, 低4位为通道号 (单适配器时即通道号)
+inline uint8_t FlightChannel(int adapter, int channel) { return (uint8_t)((adapter << 4) | (channel & 0x0F)); }
+inline int FlightAdapter(uint8_t flight_channel) { return flight_channel >> 4; }
+inline int FlightBusChannel(uint8_t flight_channel) { return flight_channel & 0x0F; }
+
+struct alignas(64) FlightStreamHeader
+{
+	uint64_t offset;   // 记录区相对文件头的偏移
+	uint64_t capacity; // 记录条数, 2的幂
+	std::atomic<uint64_t> head;
+};
+
+struct FlightFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t num_streams;
+	uint32_t reserved;
+	int64_t start_monotonic_ns; // 与 start_realtime_ns 同一时刻, 用于换算墙钟时间
+	int64_t start_realtime_ns;
+	FlightStreamHeader streams[kFlightNumStreams];
+};
+static_assert(sizeof(FlightFileHeader) <= kFlightHeaderSize, "flight header too large");
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+			  "flight recorder needs lock-free atomics in shared memory");
+
+// 从记录文件读出的一条记录, 可复制
+struct FlightEvent
+{
+	int64_t t_ns;
+	uint32_t seq;	// 环内写入顺序
+	uint8_t stream; // FlightStream
+	uint8_t type;	// FlightRecordType
+	uint8_t channel;
+	uint16_t id;
+	uint8_t payload[kFlightPayloadSize];
+};
+
+struct FlightTrace
+{
+	int64_t start_monotonic_ns = 0;
+	int64_t start_realtime_ns = 0;
+	std::vector<FlightEvent> events; // 各环合并, 按时间排序
+};
+
+// 读取记录文件或导出文件, 跳过写到一半的记录; 失败时打印原因并返回 false
+bool LoadFlightTrace(const std::string &path, FlightTrace &trace);
+
+class FlightRecorder
+{
+public:
+	FlightRecorder() = default;
+	~FlightRecorder();
+
+	FlightRecorder(const FlightRecorder &) = delete;
+	FlightRecorder &operator=(const FlightRecorder &) = delete;
+
+	// 创建并预取记录文件, 失败时记录器保持关闭, Append 为空操作
+	// 已有的记录文件改名为 <path>.prev 保留 (上次崩溃的现场), 不会被截断
+	bool Open(const FlightRecorderConfig &config);
+	void Close();
+	bool IsOpen() const { return header_ != nullptr; }
+
+	// 热路径, 可在任意线程调用
+	void Append(FlightStream stream, FlightRecordType type, uint8_t channel, uint32_t id,
+				const void *payload, size_t size, int64_t t_ns);
+
+	// 导出每个环中从 end_ns - window_ns 起的全部记录, 文件格式与记录文件相同; end_ns 为 0 时取当前时间
+	// 仅使用 open/write/close, 可在信号处理函数中调用
+	bool DumpRecent(const char *path, int64_t window_ns, int64_t end_ns = 0) const;
+
+	// SIGSEGV/SIGBUS/SIGFPE/SIGILL/SIGABRT 时导出后按默认方式结束进程
+	void InstallFaultHandlers();
+
+	// 按配置的 dump_path / dump_seconds 导出, end_ns 同 DumpRecent (如收到 SIGINT 的时刻)
+	bool DumpConfigured(int64_t end_ns = 0) const;
+
+private:
+	static void FaultHandler(int sig);
+
+	FlightFileHeader *header_ = nullptr;
+	FlightRecord *streams_[kFlightNumStreams] = {};
+	uint64_t masks_[kFlightNumStreams] = {};
+	size_t map_size_ = 0;
+
+	char dump_path_[256] = {};
+	int64_t dump_window_ns_ = 0;
+};
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,47 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef IO_REACTOR_H
+#define IO_REACTOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 单线程 epoll 循环: 登记的描述符可读时在本线程内直接调用其处理函数, 无轮询无休眠
+// 描述符均为水平触发, 处理函数需读到无数据为止 (或留待下一次唤醒)
+// Add 只能在 Run 之前调用; Stop 可在任意线程调用, 经控制 eventfd 唤醒循环
+class IoReactor
+{
+public:
+	static constexpr int kMaxEvents = 16;
+	using Handler = std::function<void()>;
+
+	IoReactor() = default;
+	~IoReactor();
+	IoReactor(const IoReactor &) = delete;
+	IoReactor &operator=(const IoReactor &) = delete;
+
+	bool Open();
+	void Close();
+	bool IsOpen() const { return epoll_fd_ >= 0; }
+
+	// 登记一个可读描述符, 描述符由调用方持有
+	bool Add(int fd, Handler handler);
+
+	// 阻塞处理事件直到 Stop
+	void Run();
+	void Stop();
+
+	uint64_t Wakeups() const { return wakeups_.load(std::memory_order_relaxed); }
+	uint64_t Dispatches() const { return dispatches_.load(std::memory_order_relaxed); }
+
+private:
+	int epoll_fd_ = -1;
+	int control_fd_ = -1;
+	std::vector<Handler> handlers_;
+	std::atomic<uint64_t> wakeups_{0};
+	std::atomic<uint64_t> dispatches_{0};
+};
+
+#endif // IO_REACTOR_H
@@ -0,0 +1,89 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// 对数线性分桶的延迟直方图 (HDR 风格, 每个二进制量级16个子桶, 相对误差 < 6.25%)
+// 记录只做一次 relaxed 原子加, 不加锁不分配, 可在实时线程中使用; 读取端随时扫描
+class LatencyHistogram
+{
+public:
+	static constexpr int kSubBits = 4;
+	static constexpr int kSubBuckets = 1 << kSubBits;
+	static constexpr int kNumBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+	LatencyHistogram() { Reset(); }
+
+	void Record(int64_t value_ns)
+	{
+		const uint64_t v = value_ns > 0 ? (uint64_t)value_ns : 0;
+		buckets_[BucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+		count_.fetch_add(1, std::memory_order_relaxed);
+
+		uint64_t max = max_.load(std::memory_order_relaxed);
+		while (v > max && !max_.compare_exchange_weak(max, v, std::memory_order_relaxed))
+			;
+	}
+
+	uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+	int64_t Max() const { return (int64_t)max_.load(std::memory_order_relaxed); }
+
+	// q 取 0~1, 返回所在桶的上界 (ns), 不超过最大值
+	int64_t Percentile(double q) const
+	{
+		const uint64_t total = Count();
+		if (total == 0)
+			return 0;
+
+		uint64_t target = (uint64_t)(q * (double)total + 0.5);
+		if (target == 0)
+			target = 1;
+
+		uint64_t seen = 0;
+		for (int i = 0; i < kNumBuckets; ++i)
+		{
+			seen += buckets_[i].load(std::memory_order_relaxed);
+			if (seen >= target)
+				return std::min((int64_t)BucketUpperBound(i), Max());
+		}
+		return Max();
+	}
+
+	void Reset()
+	{
+		for (auto &bucket : buckets_)
+			bucket.store(0, std::memory_order_relaxed);
+		count_.store(0, std::memory_order_relaxed);
+		max_.store(0, std::memory_order_relaxed);
+	}
+
+	static int BucketIndex(uint64_t v)
+	{
+		if (v < (uint64_t)kSubBuckets)
+			return (int)v;
+		const int msb = 63 - __builtin_clzll(v);
+		const int sub = (int)((v >> (msb - kSubBits)) & (kSubBuckets - 1));
+		return (msb - kSubBits + 1) * kSubBuckets + sub;
+	}
+
+	static uint64_t BucketUpperBound(int index)
+	{
+		if (index < kSubBuckets)
+			return (uint64_t)index;
+		const int shift = index / kSubBuckets - 1;
+		const uint64_t sub = (uint64_t)(index % kSubBuckets);
+		return ((kSubBuckets + sub + 1) << shift) - 1;
+	}
+
+private:
+	std::array<std::atomic<uint64_t>, kNumBuckets> buckets_;
+	std::atomic<uint64_t> count_;
+	std::atomic<uint64_t> max_;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,64 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef MIT_CODEC_H
+#define MIT_CODEC_H
+
+#include <cstdint>
+
+#include "dm_motor_protocol.h"
+
+// 整机12个电机的 MIT 帧批量编解码
+// 输入输出均为 SoA 数组, 下标即批内序号 (由调用方约定, 如 TX 调度表的槽位)
+// 限幅与定点化按4路并行: x86 用 SSE2, ARM 用 NEON, 其他平台退回标量
+constexpr int kMitBatchSize = 12;
+
+struct MitCommandBatch
+{
+	alignas(16) float position[kMitBatchSize];
+	alignas(16) float velocity[kMitBatchSize];
+	alignas(16) float kp[kMitBatchSize];
+	alignas(16) float kd[kMitBatchSize];
+	alignas(16) float torque[kMitBatchSize];
+};
+
+struct MitFeedbackBatch
+{
+	alignas(16) float position[kMitBatchSize];
+	alignas(16) float velocity[kMitBatchSize];
+	alignas(16) float torque[kMitBatchSize];
+	uint8_t err[kMitBatchSize];
+	uint8_t temp_mos[kMitBatchSize];
+	uint8_t temp_rotor[kMitBatchSize];
+};
+
+class MitBatchCodec
+{
+public:
+	// 默认全部为 DM8006 扭矩范围
+	MitBatchCodec();
+
+	// 设置第 i 个电机的扭矩范围 (DM8006 / DM8009)
+	void SetTorqueLimits(int i, float tau_min, float tau_max);
+
+	// 限幅并定点化, 写出 12 x 8 字节连续负载
+	void Encode(const MitCommandBatch &cmd, uint8_t (*payloads)[8]) const;
+
+	// 解析 12 帧反馈负载
+	void Decode(const uint8_t (*payloads)[8], MitFeedbackBatch &fb) const;
+
+private:
+	// 每路的下限、上限、编码比例 ((1 << bits) - 1) / span、解码比例 span / ((1 << bits) - 1)
+	struct FieldScale
+	{
+		alignas(16) float lo[kMitBatchSize];
+		alignas(16) float hi[kMitBatchSize];
+		alignas(16) float enc[kMitBatchSize];
+		alignas(16) float dec[kMitBatchSize];
+
+		void Set(int i, float min, float max, int bits);
+	};
+
+	FieldScale position_, velocity_, kp_, kd_, torque_;
+};
+
+#endif // MIT_CODEC_H
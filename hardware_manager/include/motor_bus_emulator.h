@@ -0,0 +1,115 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef MOTOR_BUS_EMULATOR_H
+#define MOTOR_BUS_EMULATOR_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "can_transport.h"
+#include "config_loader.h"
+#include "dm_motor_protocol.h"
+
+// 达妙 DM8006/DM8009 电机总线仿真
+// 解码 MIT 控制帧与使能/失能/置零指令, 按简单的单关节模型积分,
+// 经过可配置的延迟、抖动与丢帧后回送 0x11~0x17 反馈帧
+class MotorBusEmulator
+{
+public:
+	static constexpr int kNumChannels = 2;
+	static constexpr int kNumIds = 8; // 电机ID 1~7, 下标0不用
+
+	struct Stats
+	{
+		uint64_t rx_frames;      // 收到的指令帧
+		uint64_t tx_frames;      // 已送达的反馈帧
+		uint64_t dropped_frames; // 按 loss_rate 丢弃的反馈帧
+		uint64_t unknown_frames; // 通道或ID不在仿真范围内
+	};
+
+	explicit MotorBusEmulator(const CanEmulatorConfig &config);
+	~MotorBusEmulator();
+
+	// 启动投递线程, 反馈帧通过 bus.Inject 送回
+	void Start(LoopbackCanTransport &bus);
+	void Stop();
+
+	// LoopbackCanTransport 的 responder, 在发送线程中调用
+	void OnFrame(const CanFrame &tx);
+
+	Stats GetStats() const;
+	float GetPosition(int channel, int id) const;
+
+private:
+	struct Joint
+	{
+		bool enabled = false;
+		float tau_min = T_MIN_8006;
+		float tau_max = T_MAX_8006;
+
+		// 最近一次 MIT 指令
+		float p_des = 0.0f, v_des = 0.0f, kp = 0.0f, kd = 0.0f, t_ff = 0.0f;
+
+		// 状态
+		double q = 0.0, dq = 0.0, tau = 0.0;
+		int64_t last_ns = 0;
+	};
+
+	struct Pending
+	{
+		int64_t due_ns;
+		CanFrame frame;
+		bool operator>(const Pending &other) const { return due_ns > other.due_ns; }
+	};
+
+	static constexpr int64_t kMaxStepNs = 200000;      // 积分子步长 0.2 ms
+	static constexpr int64_t kMaxIntegrateNs = 50000000; // 单次最多积分 50 ms, 防止长时间空闲后发散
+
+	void Integrate(Joint &joint, int64_t now_ns);
+	void EncodeFeedback(const Joint &joint, uint8_t id, uint8_t *data) const;
+	void DeliveryThread();
+
+	CanEmulatorConfig config_;
+	int64_t frame_time_ns_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable cv_;
+	std::array<std::array<Joint, kNumIds>, kNumChannels + 1> joints_;
+	std::array<int64_t, kNumChannels + 1> bus_free_ns_{};
+	std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> pending_;
+	std::mt19937 rng_;
+
+	LoopbackCanTransport *bus_ = nullptr;
+	std::thread thread_;
+	bool running_ = false;
+
+	uint64_t rx_frames_ = 0;
+	uint64_t dropped_frames_ = 0;
+	uint64_t unknown_frames_ = 0;
+	std::atomic<uint64_t> tx_frames_{0};
+};
+
+// 接入电机仿真的回环传输层, can_transport.type = emulator
+class EmulatedCanTransport : public LoopbackCanTransport
+{
+public:
+	explicit EmulatedCanTransport(const CanEmulatorConfig &config);
+
+	bool Open() override;
+	void Close() override;
+	const char *Name() const override { return "emulator"; }
+
+	MotorBusEmulator &Emulator() { return emulator_; }
+
+private:
+	MotorBusEmulator emulator_;
+};
+
+#endif // MOTOR_BUS_EMULATOR_H
@@ -0,0 +1,81 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef REPLAY_ENGINE_H
+#define REPLAY_ENGINE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Tangair_usb2can_motor_imu.h"
+#include "flight_recorder.h"
+#include "latency_histogram.h"
+
+// 用飞行记录文件驱动 Tangair_usb2can, 不需要机器人
+// RX帧 -> CAN_RX_Decode, IMU样本 -> StoreImuSample, LowCmd -> LowCmdMessageHandler,
+// 记录中每个TX周期的起点 -> UpdateMotorState + ControlStep, 发出的12帧与记录逐字节比较
+// 多适配器拓扑下只比较第1个适配器上的帧 (其余适配器由各自线程并行发送, 帧间顺序不固定)
+// 要求 robot 以 replay_mode 构造 (回环传输层), 且未启动 RX/TX 线程
+struct ReplayOptions
+{
+	bool realtime = true; // true: 按记录的时间间隔回放 (延迟回归); false: 最快速度 (吞吐基准)
+	bool compare_tx = true;
+	int publish_divider = 1; // 每 N 个周期发布一次 LowState
+};
+
+struct ReplayReport
+{
+	uint64_t events = 0;
+	uint64_t rx_frames = 0;
+	uint64_t imu_samples = 0;
+	uint64_t lowcmds = 0;
+	uint64_t cycles = 0;
+	uint64_t tx_compared = 0;	// 逐字节比较的帧数
+	uint64_t tx_mismatches = 0; // 通道/ID/数据任一不同
+	uint64_t tx_missing = 0;	// 记录中有而回放未发出
+	uint64_t tx_extra = 0;		// 回放发出而记录中没有
+	int64_t first_mismatch_cycle = -1;
+	int64_t trace_ns = 0; // 记录跨度
+	int64_t wall_ns = 0;  // 回放耗时
+	int64_t lateness_p99_ns = 0; // 按记录时间回放时事件的滞后
+	int64_t lateness_max_ns = 0;
+	int64_t cycle_p50_ns = 0; // 每周期 UpdateMotorState + ControlStep 的耗时
+	int64_t cycle_p99_ns = 0;
+	int64_t cycle_max_ns = 0;
+};
+
+class ReplayEngine
+{
+public:
+	explicit ReplayEngine(Tangair_usb2can &robot);
+
+	bool Load(const std::string &path);
+	ReplayReport Run(const ReplayOptions &options);
+
+	static void PrintReport(const ReplayReport &report, const ReplayOptions &options);
+
+private:
+	void ReplayLowCmd(const FlightEvent &e);
+	void ReplayImu(const FlightEvent &e);
+	void RunCycle(size_t tx_index, const ReplayOptions &options, ReplayReport &report);
+
+	static bool IsCommandFrame(const FlightEvent &e);
+	const CAN_TX_Slot_Struct &FirstSlot() const;
+
+	Tangair_usb2can &robot_;
+	FlightTrace trace_;
+
+	// 记录中的控制帧 (不含使能/失能/置零), 按时间排列
+	std::vector<const FlightEvent *> tx_frames_;
+
+	// LowCmd 的 q/kp/kd 三条记录拼成一帧消息
+	unitree_go::msg::dds_::LowCmd_ low_cmd_{};
+	uint8_t low_cmd_parts_ = 0;
+	bool low_cmd_seen_ = false;
+
+	LatencyHistogram lateness_;
+	LatencyHistogram cycle_exec_;
+	uint64_t cycle_index_ = 0;
+};
+
+#endif // REPLAY_ENGINE_H
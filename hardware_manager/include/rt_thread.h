@@ -0,0 +1,116 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef RT_THREAD_H
+#define RT_THREAD_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <alloca.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "config_loader.h"
+
+// 绑定当前线程到指定CPU并设置 SCHED_FIFO 优先级, cpu < 0 不绑定, priority <= 0 不修改调度
+inline bool SetCurrentThreadRealtime(const char* name, int cpu, int priority)
+{
+	bool ok = true;
+
+	if (cpu >= 0) {
+		cpu_set_t cpuset;
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu, &cpuset);
+		int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+		if (ret != 0) {
+			std::cerr << "[WARN] " << name << ": 绑定 CPU " << cpu << " 失败: " << strerror(ret) << "\n";
+			ok = false;
+		}
+	}
+
+	if (priority > 0) {
+		sched_param param;
+		param.sched_priority = priority;
+		int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (ret != 0) {
+			std::cerr << "[WARN] " << name << ": 设置 SCHED_FIFO " << priority << " 失败: " << strerror(ret) << "\n";
+			ok = false;
+		}
+	}
+
+	pthread_setname_np(pthread_self(), name);
+	return ok;
+}
+
+// 按 tid 设置其他线程 (如 XDA 内部线程) 的CPU与优先级, priority <= 0 使用 SCHED_OTHER
+inline bool SetThreadRealtimeByTid(pid_t tid, int cpu, int priority)
+{
+	bool ok = true;
+
+	if (cpu >= 0) {
+		cpu_set_t cpuset;
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu, &cpuset);
+		if (sched_setaffinity(tid, sizeof(cpuset), &cpuset) != 0)
+			ok = false;
+	}
+
+	sched_param param;
+	param.sched_priority = priority > 0 ? priority : 0;
+	if (sched_setscheduler(tid, priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param) != 0)
+		ok = false;
+
+	if (!ok)
+		std::cerr << "[WARN] tid " << tid << ": 设置 CPU " << cpu << " / 优先级 " << priority << " 失败: " << strerror(errno) << "\n";
+	return ok;
+}
+
+// 当前进程的全部线程 tid
+inline std::vector<pid_t> ListProcessThreads()
+{
+	std::vector<pid_t> tids;
+	DIR* dir = opendir("/proc/self/task");
+	if (!dir)
+		return tids;
+	while (struct dirent* entry = readdir(dir)) {
+		if (entry->d_name[0] != '.')
+			tids.push_back((pid_t)atoi(entry->d_name));
+	}
+	closedir(dir);
+	return tids;
+}
+
+// 预先触碰栈空间, 配合 mlockall 使栈页在进入实时循环前就已驻留
+inline void PrefaultStack(size_t bytes)
+{
+	if (bytes == 0)
+		return;
+	volatile unsigned char* buf = (volatile unsigned char*)alloca(bytes);
+	for (size_t i = 0; i < bytes; i += 4096)
+		buf[i] = 0;
+}
+
+// 线程入口处调用: 按配置设置CPU/优先级并预取栈
+inline bool ApplyThreadRtConfig(const char* name, const ThreadRtConfig& cfg, size_t prefault_stack_bytes)
+{
+	bool ok = SetCurrentThreadRealtime(name, cfg.cpu, cfg.priority);
+	PrefaultStack(prefault_stack_bytes);
+	return ok;
+}
+
+// 锁定进程内存, 避免实时线程缺页
+inline bool LockProcessMemory()
+{
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+		std::cerr << "[WARN] mlockall 失败: " << strerror(errno) << "\n";
+		return false;
+	}
+	return true;
+}
+
+#endif // RT_THREAD_H
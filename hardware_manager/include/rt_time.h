@@ -0,0 +1,17 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef RT_TIME_H
+#define RT_TIME_H
+
+#include <cstdint>
+#include <time.h>
+
+// CLOCK_MONOTONIC 时间戳, 单位ns, vDSO 调用不陷入内核
+inline int64_t MonotonicNowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+#endif // RT_TIME_H
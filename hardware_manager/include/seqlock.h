@@ -0,0 +1,53 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// 单写多读的序列锁: 写端从不阻塞, 读端在写入过程中重试, 不分配内存
+// T 必须可平凡复制 (固定大小的 POD 状态块)
+template <typename T>
+class SeqLock
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+	SeqLock() : seq_(0) { std::memset(&data_, 0, sizeof(T)); }
+	explicit SeqLock(const T &init) : seq_(0) { std::memcpy(&data_, &init, sizeof(T)); }
+
+	// 只允许一个写线程
+	void Store(const T &value)
+	{
+		const uint32_t seq = seq_.load(std::memory_order_relaxed);
+		seq_.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		std::memcpy(&data_, &value, sizeof(T));
+		seq_.store(seq + 2, std::memory_order_release);
+	}
+
+	T Load() const
+	{
+		T copy;
+		uint32_t begin, end;
+		do {
+			begin = seq_.load(std::memory_order_acquire);
+			std::memcpy(&copy, &data_, sizeof(T));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			end = seq_.load(std::memory_order_relaxed);
+		} while ((begin & 1) || begin != end);
+		return copy;
+	}
+
+	// 已完成的写入次数
+	uint32_t Version() const { return seq_.load(std::memory_order_acquire) >> 1; }
+
+private:
+	alignas(64) std::atomic<uint32_t> seq_;
+	alignas(64) T data_;
+};
+
+#endif // SEQLOCK_H
@@ -0,0 +1,91 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 单生产者单消费者环形缓冲, 容量固定, 满时覆盖最旧的元素并计入丢弃数
+// 生产端无等待; 消费端读取期间登记所读槽位, 生产端不会覆盖正在被读的槽位
+// (此时改为丢弃最新元素), 因此 T 可以是非平凡类型, 槽位在构造时一次性分配
+template <typename T, size_t N>
+class SpscRing
+{
+	static_assert(N >= 2, "SpscRing needs at least two slots");
+
+public:
+	SpscRing() : head_(0), tail_(0), reading_(kIdle), dropped_(0) {}
+
+	// 生产端
+	void push(const T &value)
+	{
+		const uint64_t head = head_.load(std::memory_order_relaxed);
+		uint64_t tail = tail_.load(std::memory_order_acquire);
+
+		// 已满: 丢弃最旧的元素, CAS 失败说明消费端刚好取走了它
+		if (head - tail >= N && tail_.compare_exchange_strong(tail, tail + 1, std::memory_order_seq_cst))
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+
+		// 目标槽位正被消费端读取, 丢弃本次写入
+		if (head >= N && reading_.load(std::memory_order_seq_cst) == head - N)
+		{
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		slots_[head % N] = value;
+		head_.store(head + 1, std::memory_order_release);
+	}
+
+	// 消费端
+	bool pop(T &out)
+	{
+		for (;;)
+		{
+			uint64_t tail = tail_.load(std::memory_order_acquire);
+			if (tail == head_.load(std::memory_order_acquire))
+				return false;
+
+			reading_.store(tail, std::memory_order_seq_cst);
+			if (tail_.load(std::memory_order_seq_cst) != tail)
+				continue; // 已被生产端丢弃
+
+			out = slots_[tail % N];
+
+			// CAS 失败: 读取期间生产端已把该元素计为丢弃, 但槽位未被覆盖, 数据有效
+			if (!tail_.compare_exchange_strong(tail, tail + 1, std::memory_order_seq_cst))
+				dropped_.fetch_sub(1, std::memory_order_relaxed);
+
+			reading_.store(kIdle, std::memory_order_release);
+			return true;
+		}
+	}
+
+	bool empty() const
+	{
+		return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+	}
+
+	size_t size() const
+	{
+		return static_cast<size_t>(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+	}
+
+	uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+	static constexpr size_t capacity() { return N; }
+
+private:
+	static constexpr uint64_t kIdle = UINT64_MAX;
+
+	alignas(64) std::atomic<uint64_t> head_;
+	alignas(64) std::atomic<uint64_t> tail_;
+	alignas(64) std::atomic<uint64_t> reading_;
+	std::atomic<uint64_t> dropped_;
+	std::array<T, N> slots_;
+};
+
+#endif // SPSC_RING_H
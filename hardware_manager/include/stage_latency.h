@@ -0,0 +1,74 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#ifndef STAGE_LATENCY_H
+#define STAGE_LATENCY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "config_loader.h"
+#include "latency_histogram.h"
+
+// 控制链路各环节的延迟, 指令方向 LowCmd -> CAN TX, 状态方向 CAN RX -> LowState
+enum LatencyStage : uint8_t
+{
+	kStageDdsHandler = 0, // LowCmdMessageHandler 进入到指令写入
+	kStageCmdWait,		  // 指令写入到被实时循环取走
+	kStageValidate,		  // SetTargetPosition (限幅校验 + 写入各电机目标)
+	kStageTxEncode,		  // 周期开始到12帧编码完成
+	kStageTxFrame,		  // 单帧发送调用
+	kStageCmdToTx,		  // LowCmd 到达到该指令所在周期最后一帧发出 (端到端)
+	kStageRxDecode,		  // 传输层收到反馈帧到解码完成
+	kStageRxToPublish,	  // 快照中最早的新鲜样本到 LowState 发出 (端到端)
+	kStageImuToPublish,	  // IMU 样本到达回调到首次随 LowState 发出 (端到端)
+	kStagePublish,		  // PublishLowState 耗时
+	kNumLatencyStages
+};
+
+const char *LatencyStageName(int stage);
+
+// 共享内存布局, 节点与 reddog_stats 共用
+constexpr char kLatencyStatsMagic[8] = {'R', 'D', 'L', 'A', 'T', 'S', 'T', '1'};
+
+struct LatencyStatsBlock
+{
+	char magic[8];
+	uint32_t num_stages;
+	uint32_t histogram_size; // sizeof(LatencyHistogram), 读取端据此校验布局
+	int64_t start_realtime_ns;
+	LatencyHistogram stages[kNumLatencyStages];
+};
+
+// 记录端直接写入直方图 (relaxed 原子加), 不加锁、不进内核; 读取端随时扫描
+class StageLatencyStats
+{
+public:
+	StageLatencyStats();
+	~StageLatencyStats();
+
+	StageLatencyStats(const StageLatencyStats &) = delete;
+	StageLatencyStats &operator=(const StageLatencyStats &) = delete;
+
+	// 改为放在共享内存中 (覆盖同名段), 失败时继续使用进程内存
+	bool OpenShared(const std::string &name);
+
+	void Record(LatencyStage stage, int64_t ns) { block_->stages[stage].Record(ns); }
+	const LatencyHistogram &Get(LatencyStage stage) const { return block_->stages[stage]; }
+	void Reset();
+
+	// 每个环节一行: count, p50/p99/p999/max (us)
+	static void Print(const LatencyStatsBlock &block, std::ostream &os);
+	void Print(std::ostream &os) const { Print(*block_, os); }
+
+private:
+	static void InitBlock(LatencyStatsBlock *block);
+
+	std::unique_ptr<LatencyStatsBlock> local_;
+	LatencyStatsBlock *block_ = nullptr;
+	size_t shm_size_ = 0;
+};
+
+#endif // STAGE_LATENCY_H
@@ -1,40 +1,81 @@
 #include "callback_handler.h"
 #include <iostream>
 #include <iomanip>
-#include <list>
 #include <string>
 #include <cassert>
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "rt_time.h"
 
 Journaller* gJournal = 0;
 
 using namespace std;
 
-CallbackHandler::CallbackHandler(size_t maxBufferSize)
-    : m_maxNumberOfPacketsInBuffer(maxBufferSize)
-    , m_numberOfPacketsInBuffer(0) {}
+CallbackHandler::CallbackHandler()
+    : m_eventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
 
-CallbackHandler::~CallbackHandler() throw() {}
+CallbackHandler::~CallbackHandler() throw() {
+    if (m_eventFd >= 0)
+        close(m_eventFd);
+}
 
 bool CallbackHandler::packetAvailable() const {
-    xsens::Lock locky(&m_mutex);
-    return m_numberOfPacketsInBuffer > 0;
+    return !m_packetBuffer.empty();
 }
 
 XsDataPacket CallbackHandler::getNextPacket() {
-    assert(packetAvailable());
-    xsens::Lock locky(&m_mutex);
-    XsDataPacket oldestPacket(m_packetBuffer.front());
-    m_packetBuffer.pop_front();
-    --m_numberOfPacketsInBuffer;
+    XsDataPacket oldestPacket;
+    bool ok = tryGetNextPacket(oldestPacket);
+    assert(ok);
+    (void)ok;
     return oldestPacket;
 }
 
+bool CallbackHandler::tryGetNextPacket(XsDataPacket& packet, int64_t* arrival_ns) {
+    if (!m_packetBuffer.pop(m_popped))
+        return false;
+    packet = m_popped.packet;
+    if (arrival_ns)
+        *arrival_ns = m_popped.arrival_ns;
+    return true;
+}
+
+bool CallbackHandler::waitForPacket(int timeout_ms) {
+    if (packetAvailable())
+        return true;
+
+    struct pollfd pfd = { m_eventFd, POLLIN, 0 };
+    int ret = poll(&pfd, 1, timeout_ms);
+    if (ret <= 0)
+        return false;
+
+    uint64_t events;
+    while (read(m_eventFd, &events, sizeof(events)) < 0 && errno == EINTR) {}
+    return packetAvailable();
+}
+
+int CallbackHandler::eventFd() const {
+    return m_eventFd;
+}
+
+void CallbackHandler::acknowledgeEvent() {
+    uint64_t events;
+    while (read(m_eventFd, &events, sizeof(events)) < 0 && errno == EINTR) {}
+}
+
+uint64_t CallbackHandler::droppedPackets() const {
+    return m_packetBuffer.dropped();
+}
+
 void CallbackHandler::onLiveDataAvailable(XsDevice*, const XsDataPacket* packet) {
-    xsens::Lock locky(&m_mutex);
     assert(packet != 0);
-    while (m_numberOfPacketsInBuffer >= m_maxNumberOfPacketsInBuffer)
-        (void)getNextPacket();
-    m_packetBuffer.push_back(*packet);
-    ++m_numberOfPacketsInBuffer;
-    assert(m_numberOfPacketsInBuffer <= m_maxNumberOfPacketsInBuffer);
+    m_pushed.packet = *packet;
+    m_pushed.arrival_ns = MonotonicNowNs();
+    m_packetBuffer.push(m_pushed);
+
+    uint64_t one = 1;
+    ssize_t ret = write(m_eventFd, &one, sizeof(one));
+    (void)ret;
 }
@@ -2,11 +2,13 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "Tangair_usb2can_motor_imu.h"
+#include "replay_engine.h"
 #include <memory>
 #include <csignal>
 #include <unistd.h>
 #include <sched.h>
 #include <atomic>
+#include <cstring>
 #include <functional>
 #include <unordered_map>
 
@@ -15,54 +17,93 @@ using std::chrono::milliseconds;
 std::shared_ptr<Tangair_usb2can> CAN_ptr;
 
 volatile sig_atomic_t shutdown_requested = 0;
+// 收到 SIGINT 的 CLOCK_MONOTONIC 时间, 作为飞行记录导出窗口的终点
+std::atomic<int64_t> shutdown_signal_ns{0};
+
+static const char *kConfigPath = "/home/crazydog/bigrdog/bigreddog_ROS2Control/hardware_manager/config/config.yaml";
 
 void signal_callback_handler(int signum) {
+    int64_t expected = 0;
+    shutdown_signal_ns.compare_exchange_strong(expected, MonotonicNowNs());
     shutdown_requested = 1;
 }
 
+// ========== 回放模式 ==========
+// 以飛行記錄檔驅動解碼、狀態、校驗與發布路徑, 不需要機器人
+// 回傳值: 0 = 發出的 TX 幀與記錄逐位元組一致
+static int RunReplay(const std::string &trace_path, bool fast) {
+    CAN_ptr = std::make_shared<Tangair_usb2can>(kConfigPath, true);
+    CAN_ptr->SetupRealtime();
+    CAN_ptr->DDS_Init(false);
+
+    ReplayEngine engine(*CAN_ptr);
+    if (!engine.Load(trace_path))
+        return 1;
+
+    ReplayOptions options;
+    options.realtime = !fast;
+    const ReplayReport report = engine.Run(options);
+    ReplayEngine::PrintReport(report, options);
+    return report.first_mismatch_cycle < 0 && report.tx_missing == 0 && report.tx_extra == 0 ? 0 : 1;
+}
+
+// 用法: can_node_motor_imu [網卡] [--replay <記錄檔> [--fast]]
 int main(int argc, const char **argv) {
-    if (argc < 2)
+    const char *network_interface = nullptr;
+    const char *replay_path = nullptr;
+    bool replay_fast = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replay_path = argv[++i];
+        else if (std::strcmp(argv[i], "--fast") == 0)
+            replay_fast = true;
+        else
+            network_interface = argv[i];
+    }
+
+    if (!network_interface)
         ChannelFactory::Instance()->Init(1, "lo");
     else
-        ChannelFactory::Instance()->Init(0, argv[1]);
+        ChannelFactory::Instance()->Init(0, network_interface);
 
-    std::cout << "Press enter to start";
+    if (replay_path)
+        return RunReplay(replay_path, replay_fast);
 
-    // 設定 real-time 行程排程
-    pid_t pid = getpid();
-    sched_param param;
-    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
-    if (sched_setscheduler(pid, SCHED_FIFO, &param) == -1) {
-        std::cout << "[ERROR] 設定即時排程失敗。\n";
-    }
-    
+    std::cout << "Press enter to start";
 
     // ========== 開始主程式 ==========
-    CAN_ptr = std::make_shared<Tangair_usb2can>();
-    signal(SIGINT, signal_callback_handler);
+    // 各執行緒的 CPU 綁定、即時優先級與 CAN 傳輸層由 config.yaml 設定
+    CAN_ptr = std::make_shared<Tangair_usb2can>(kConfigPath);
+    // 不设 SA_RESTART: 阻塞在 std::cin 的读取被中断, 不必等待输入 Enter
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_callback_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;
+    sigaction(SIGINT, &sa, nullptr);
 
     constexpr int kDefaultDelayUs = 120;
 
+    CAN_ptr->SetupRealtime();
+
     CAN_ptr->IMU_Init();
     CAN_ptr->StartIMUThread();
 
     CAN_ptr->DDS_Init();
-    
-    CAN_ptr->LoadConfigFromYAML("/home/crazydog/bigrdog/bigreddog_ROS2Control/hardware_manager/config/config.yaml");
 
 
     std::unordered_map<std::string, std::function<void()>> command_map = {
         {"enable", []() {
-            CAN_ptr->ENABLE_ALL_MOTOR(kDefaultDelayUs); 
+            CAN_ptr->PrintMotorSequenceResult("enable", CAN_ptr->ENABLE_ALL_MOTOR(kDefaultDelayUs)); 
         }},
         {"disable", []() { 
-            CAN_ptr->DISABLE_ALL_MOTOR(kDefaultDelayUs); 
+            CAN_ptr->PrintMotorSequenceResult("disable", CAN_ptr->DISABLE_ALL_MOTOR(kDefaultDelayUs)); 
         }},
         {"passive", []() { 
-            CAN_ptr->PASSIVE_ALL_MOTOR(kDefaultDelayUs); 
+            CAN_ptr->PrintMotorSequenceResult("passive", CAN_ptr->PASSIVE_ALL_MOTOR(kDefaultDelayUs)); 
         }},
         {"set", []() { 
-            CAN_ptr->ZERO_ALL_MOTOR(kDefaultDelayUs); 
+            CAN_ptr->PrintMotorSequenceResult("zero", CAN_ptr->ZERO_ALL_MOTOR(kDefaultDelayUs)); 
         }},
         {"reset", []() {
             CAN_ptr->StopAllThreads();
@@ -75,30 +116,42 @@ int main(int argc, const char **argv) {
         {"stop", []() {
             CAN_ptr->StopAllThreads();
         }},
+        {"stats", []() {
+            CAN_ptr->PrintLatencyStats();
+        }},
         {"exit", []() {
+            CAN_ptr->DumpFlightRecorder();
             CAN_ptr->StopAllThreads();
             std::exit(0); // 安全退出
         }},
     };
 
-    std::cout << "\n請輸入指令啟動馬達操作：\n(enable / disable / passive / set / reset / position / stop / exit)\n";
+    std::cout << "\n請輸入指令啟動馬達操作：\n(enable / disable / passive / set / reset / position / stop / stats / exit)\n";
 
     while (true) {
         if (shutdown_requested) {
             std::cout << "\n[INFO] 收到中斷訊號，正在安全結束...\n";
+            // 先導出中斷前的記錄, 再停止各執行緒
+            CAN_ptr->DumpFlightRecorder(shutdown_signal_ns.load());
             CAN_ptr->StopAllThreads();
             break;
         }
 
         std::string input;
         std::cout << ">> ";
-        std::cin >> input;
+        if (!(std::cin >> input)) {
+            // 讀取被 SIGINT 中斷; 標準輸入關閉時同樣安全結束
+            if (std::cin.eof())
+                shutdown_requested = 1;
+            std::cin.clear();
+            continue;
+        }
 
         auto cmd = command_map.find(input);
         if (cmd != command_map.end()) {
             cmd->second(); // 執行對應 lambda
         } else {
-            std::cout << "[提示] 不支援的指令，請輸入：enable / disable / passive / set / reset / position / stop / exit\n";
+            std::cout << "[提示] 不支援的指令，請輸入：enable / disable / passive / set / reset / position / stop / stats / exit\n";
         }
     }
 
@@ -0,0 +1,386 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#include "can_transport.h"
+#include "motor_bus_emulator.h"
+#include "usb_can.h"
+#include "rt_time.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+
+static int64_t TimespecNs(const struct timespec &ts)
+{
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int64_t RealtimeNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return TimespecNs(ts);
+}
+
+/*********************************       *** USB2CAN ***      ***********************************************/
+
+Usb2CanTransport::Usb2CanTransport(const std::string &device) : device_(device) {}
+
+Usb2CanTransport::~Usb2CanTransport()
+{
+    Close();
+}
+
+bool Usb2CanTransport::Open()
+{
+    dev_ = openUSBCAN(device_.c_str());
+    if (dev_ == -1) {
+        std::cout << std::endl << device_ << " open INcorrect!!!" << std::endl;
+        return false;
+    }
+    std::cout << std::endl << device_ << " opened ,num=" << dev_ << std::endl;
+    return true;
+}
+
+void Usb2CanTransport::Close()
+{
+    if (dev_ != -1) {
+        closeUSBCAN(dev_);
+        dev_ = -1;
+    }
+}
+
+int Usb2CanTransport::Send(const CanFrame *frames, int count)
+{
+    // libusb_can 每次调用只能发送一帧
+    int sent = 0;
+    for (int i = 0; i < count; ++i) {
+        FrameInfo info = {
+            .canID = frames[i].can_id,
+            .frameType = STANDARD,
+            .dataLength = frames[i].dlc,
+        };
+        if (sendUSBCAN(dev_, frames[i].channel, &info, const_cast<uint8_t *>(frames[i].data)) == -1)
+            return sent > 0 ? sent : -1;
+        ++sent;
+    }
+    return sent;
+}
+
+std::vector<int> Usb2CanTransport::PollFds() const
+{
+    if (dev_ < 0)
+        return {};
+    return {dev_};
+}
+
+/// @brief 串口缓冲中已有字节时, 等到够一整帧再读; 超时返回 false, 已到的字节留给下一次
+bool Usb2CanTransport::WaitFrameBytes(int timeout_us) const
+{
+    const int64_t deadline_ns = MonotonicNowNs() + (int64_t)timeout_us * 1000;
+    while (true) {
+        int available = 0;
+        if (ioctl(dev_, FIONREAD, &available) < 0)
+            return false;
+        if (available >= kFrameBytes)
+            return true;
+        if (MonotonicNowNs() >= deadline_ns)
+            return false;
+        const struct timespec pause = {0, 20000};
+        nanosleep(&pause, nullptr);
+    }
+}
+
+int Usb2CanTransport::Receive(CanFrame *frames, int max_frames, int timeout_us)
+{
+    FrameInfo info;
+    int got = 0;
+
+    while (got < max_frames) {
+        // 第一帧在 poll 上睡眠等待 (最多 timeout_us), 之后只取已到达的帧;
+        // readUSBCAN 自身的超时按 clock() 忙等, 不能用来阻塞
+        struct pollfd pfd = {dev_, POLLIN, 0};
+        const int poll_ms = (got == 0 && timeout_us > 0) ? (timeout_us + 999) / 1000 : 0;
+        if (poll(&pfd, 1, poll_ms) <= 0)
+            break;
+        if (!WaitFrameBytes(kFrameReadTimeoutUs))
+            break;
+
+        CanFrame &frame = frames[got];
+        if (readUSBCAN(dev_, &frame.channel, &info, frame.data, kFrameReadTimeoutUs) == -1)
+            break;
+        frame.can_id = info.canID;
+        frame.dlc = info.dataLength;
+        frame.timestamp_ns = MonotonicNowNs();
+        frame.hw_timestamp_ns = 0;
+        ++got;
+    }
+    return got;
+}
+
+/*********************************       *** SocketCAN ***      ***********************************************/
+
+SocketCanTransport::SocketCanTransport(const std::vector<std::string> &interfaces) : interfaces_(interfaces) {}
+
+SocketCanTransport::~SocketCanTransport()
+{
+    Close();
+}
+
+bool SocketCanTransport::Open()
+{
+    Close();
+
+    for (const auto &name : interfaces_) {
+        int fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+        if (fd < 0) {
+            std::cerr << "[ERROR] socketcan " << name << ": socket 失败: " << strerror(errno) << std::endl;
+            Close();
+            return false;
+        }
+
+        struct ifreq ifr = {};
+        strncpy(ifr.ifr_name, name.c_str(), IFNAMSIZ - 1);
+        if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+            std::cerr << "[ERROR] socketcan " << name << ": 找不到接口: " << strerror(errno) << std::endl;
+            close(fd);
+            Close();
+            return false;
+        }
+
+        struct sockaddr_can addr = {};
+        addr.can_family = AF_CAN;
+        addr.can_ifindex = ifr.ifr_ifindex;
+        if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+            std::cerr << "[ERROR] socketcan " << name << ": bind 失败: " << strerror(errno) << std::endl;
+            close(fd);
+            Close();
+            return false;
+        }
+
+        // 时间戳不可用时不影响收发, 退回用户态取时间
+        const int ts_flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+                             SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+        if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &ts_flags, sizeof(ts_flags)) < 0)
+            std::cerr << "[WARN] socketcan " << name << ": 不支持 SO_TIMESTAMPING: " << strerror(errno) << std::endl;
+
+        sockets_.push_back(fd);
+        std::cout << "[INFO] socketcan " << name << " -> channel " << sockets_.size() << std::endl;
+    }
+    return true;
+}
+
+void SocketCanTransport::Close()
+{
+    for (int fd : sockets_)
+        close(fd);
+    sockets_.clear();
+}
+
+int SocketCanTransport::Send(const CanFrame *frames, int count)
+{
+    int sent = 0;
+
+    // 按通道分组, 每个套接字一次 sendmmsg
+    for (size_t ch = 0; ch < sockets_.size(); ++ch) {
+        struct can_frame cf[kMaxBatch];
+        struct iovec iov[kMaxBatch];
+        struct mmsghdr msgs[kMaxBatch];
+        int n = 0;
+
+        for (int i = 0; i < count; ++i) {
+            if (frames[i].channel != ch + 1)
+                continue;
+
+            if (n == kMaxBatch) {
+                int ret = sendmmsg(sockets_[ch], msgs, n, 0);
+                if (ret > 0) sent += ret;
+                n = 0;
+            }
+
+            memset(&cf[n], 0, sizeof(cf[n]));
+            cf[n].can_id = frames[i].can_id & CAN_SFF_MASK;
+            cf[n].can_dlc = std::min<uint8_t>(frames[i].dlc, 8);
+            memcpy(cf[n].data, frames[i].data, cf[n].can_dlc);
+
+            iov[n].iov_base = &cf[n];
+            iov[n].iov_len = sizeof(cf[n]);
+            memset(&msgs[n], 0, sizeof(msgs[n]));
+            msgs[n].msg_hdr.msg_iov = &iov[n];
+            msgs[n].msg_hdr.msg_iovlen = 1;
+            ++n;
+        }
+
+        if (n > 0) {
+            int ret = sendmmsg(sockets_[ch], msgs, n, 0);
+            if (ret > 0) sent += ret;
+        }
+    }
+
+    return sent;
+}
+
+int SocketCanTransport::Receive(CanFrame *frames, int max_frames, int timeout_us)
+{
+    if (max_frames <= 0 || sockets_.empty())
+        return 0;
+
+    struct pollfd pfds[8];
+    const int nfds = (int)std::min<size_t>(sockets_.size(), 8);
+    for (int i = 0; i < nfds; ++i)
+        pfds[i] = {sockets_[i], POLLIN, 0};
+
+    struct timespec ts = {timeout_us / 1000000, (long)(timeout_us % 1000000) * 1000};
+    int ready = ppoll(pfds, nfds, timeout_us < 0 ? nullptr : &ts, nullptr);
+    if (ready < 0)
+        return errno == EINTR ? 0 : -1;
+    if (ready == 0)
+        return 0;
+
+    // 内核软件时间戳为 CLOCK_REALTIME, 每批取一次两个时钟的差换算到 CLOCK_MONOTONIC
+    const int64_t now_ns = MonotonicNowNs();
+    const int64_t realtime_offset_ns = now_ns - RealtimeNowNs();
+    int got = 0;
+
+    for (int i = 0; i < nfds && got < max_frames; ++i) {
+        if (!(pfds[i].revents & POLLIN))
+            continue;
+
+        struct can_frame cf[kMaxBatch];
+        struct iovec iov[kMaxBatch];
+        struct mmsghdr msgs[kMaxBatch];
+        alignas(struct cmsghdr) char ctrl[kMaxBatch][CMSG_SPACE(sizeof(struct scm_timestamping))];
+        const int want = std::min(max_frames - got, kMaxBatch);
+        for (int k = 0; k < want; ++k) {
+            iov[k].iov_base = &cf[k];
+            iov[k].iov_len = sizeof(cf[k]);
+            memset(&msgs[k], 0, sizeof(msgs[k]));
+            msgs[k].msg_hdr.msg_iov = &iov[k];
+            msgs[k].msg_hdr.msg_iovlen = 1;
+            msgs[k].msg_hdr.msg_control = ctrl[k];
+            msgs[k].msg_hdr.msg_controllen = sizeof(ctrl[k]);
+        }
+
+        int n = recvmmsg(sockets_[i], msgs, want, MSG_DONTWAIT, nullptr);
+        for (int k = 0; k < n; ++k) {
+            CanFrame &frame = frames[got++];
+            frame.channel = (uint8_t)(i + 1);
+            frame.can_id = cf[k].can_id & CAN_SFF_MASK;
+            frame.dlc = cf[k].can_dlc;
+            memcpy(frame.data, cf[k].data, 8);
+            frame.timestamp_ns = now_ns;
+            frame.hw_timestamp_ns = 0;
+
+            for (struct cmsghdr *c = CMSG_FIRSTHDR(&msgs[k].msg_hdr); c; c = CMSG_NXTHDR(&msgs[k].msg_hdr, c)) {
+                if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_TIMESTAMPING)
+                    continue;
+                struct scm_timestamping stamp;
+                memcpy(&stamp, CMSG_DATA(c), sizeof(stamp));
+                if (stamp.ts[0].tv_sec != 0 || stamp.ts[0].tv_nsec != 0)
+                    frame.timestamp_ns = TimespecNs(stamp.ts[0]) + realtime_offset_ns;
+                frame.hw_timestamp_ns = TimespecNs(stamp.ts[2]);
+            }
+        }
+    }
+
+    return got;
+}
+
+/*********************************       *** Loopback ***      ***********************************************/
+
+LoopbackCanTransport::LoopbackCanTransport() : event_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+
+LoopbackCanTransport::~LoopbackCanTransport()
+{
+    if (event_fd_ >= 0)
+        close(event_fd_);
+}
+
+std::vector<int> LoopbackCanTransport::PollFds() const
+{
+    if (event_fd_ < 0)
+        return {};
+    return {event_fd_};
+}
+
+void LoopbackCanTransport::SetResponder(Responder responder)
+{
+    responder_ = std::move(responder);
+}
+
+bool LoopbackCanTransport::Inject(const CanFrame &frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (head_ - tail_ >= kQueueSize)
+            return false;
+        queue_[head_ % kQueueSize] = frame;
+        queue_[head_ % kQueueSize].timestamp_ns = MonotonicNowNs();
+        queue_[head_ % kQueueSize].hw_timestamp_ns = 0;
+        ++head_;
+        if (event_fd_ >= 0) {
+            const uint64_t one = 1;
+            (void)!write(event_fd_, &one, sizeof(one));
+        }
+    }
+    cv_.notify_one();
+    return true;
+}
+
+int LoopbackCanTransport::Send(const CanFrame *frames, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (responder_)
+            responder_(frames[i], *this);
+        else
+            Inject(frames[i]);
+    }
+    return count;
+}
+
+int LoopbackCanTransport::Receive(CanFrame *frames, int max_frames, int timeout_us)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!cv_.wait_for(lock, std::chrono::microseconds(timeout_us), [this] { return head_ != tail_; }))
+        return 0;
+
+    int got = 0;
+    while (got < max_frames && tail_ != head_)
+        frames[got++] = queue_[tail_++ % kQueueSize];
+
+    // 取空后清除 eventfd, 与 Inject 在同一把锁内, 不会漏掉新帧
+    if (tail_ == head_ && event_fd_ >= 0) {
+        uint64_t events = 0;
+        (void)!read(event_fd_, &events, sizeof(events));
+    }
+    return got;
+}
+
+/*********************************       *** Factory ***      ***********************************************/
+
+std::unique_ptr<CanTransport> CreateCanTransport(const CanTransportConfig &config)
+{
+    if (config.type == "usb2can")
+        return std::unique_ptr<CanTransport>(new Usb2CanTransport(config.device));
+    if (config.type == "socketcan")
+        return std::unique_ptr<CanTransport>(new SocketCanTransport(config.interfaces));
+    if (config.type == "loopback")
+        return std::unique_ptr<CanTransport>(new LoopbackCanTransport());
+    if (config.type == "emulator")
+        return std::unique_ptr<CanTransport>(new EmulatedCanTransport(config.emulator));
+
+    std::cerr << "[ERROR] Unknown can_transport type: " << config.type << ", fall back to usb2can" << std::endl;
+    return std::unique_ptr<CanTransport>(new Usb2CanTransport(config.device));
+}
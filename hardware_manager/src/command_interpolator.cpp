@@ -0,0 +1,172 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#include "command_interpolator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static bool AllFinite(const double *values)
+{
+    for (int i = 0; i < kNumCommandJoints; ++i)
+        if (!std::isfinite(values[i]))
+            return false;
+    return true;
+}
+
+void CommandInterpolator::Configure(const CommandInterpolationConfig &config, int64_t control_period_ns)
+{
+    config_ = config;
+    min_interval_ns_ = std::max<int64_t>(control_period_ns, 1);
+    max_interval_ns_ = std::max<int64_t>((int64_t)(config.max_interval_ms * 1e6), min_interval_ns_);
+    extrapolate_ns_ = std::max<int64_t>((int64_t)(config.extrapolate_ms * 1e6), 0);
+    Reset();
+}
+
+void CommandInterpolator::Reset()
+{
+    primed_ = false;
+    last_arrival_ns_ = 0;
+    interval_ns_ = 0;
+    commands_.store(0, std::memory_order_relaxed);
+    rejected_.store(0, std::memory_order_relaxed);
+    samples_.store(0, std::memory_order_relaxed);
+    extrapolated_.store(0, std::memory_order_relaxed);
+    held_.store(0, std::memory_order_relaxed);
+    interval_stat_ns_.store(0, std::memory_order_relaxed);
+}
+
+bool CommandInterpolator::Push(const double *position, const double *velocity, int64_t arrival_ns, int64_t start_ns)
+{
+    commands_.fetch_add(1, std::memory_order_relaxed);
+
+    // 非有限值一旦进入 p1_ / v1_ 会经 out_p_ 带入之后每一段, 在此丢弃
+    if (!AllFinite(position) || (config_.mode == InterpolationMode::kCubic && !AllFinite(velocity))) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // 第一条指令没有起点, 直接作为设定值; 上一次输出不可用时同样从本指令重新开始
+    if (!primed_ || !AllFinite(out_p_) || !AllFinite(out_v_)) {
+        std::memcpy(p0_, position, sizeof(p0_));
+        std::memcpy(p1_, position, sizeof(p1_));
+        std::memcpy(out_p_, position, sizeof(out_p_));
+        std::memset(v0_, 0, sizeof(v0_));
+        std::memset(v1_, 0, sizeof(v1_));
+        std::memset(out_v_, 0, sizeof(out_v_));
+        start_ns_ = start_ns;
+        duration_ns_ = min_interval_ns_;
+        last_arrival_ns_ = arrival_ns;
+        primed_ = true;
+        return true;
+    }
+
+    // 指令间隔的滑动平均 (1/8), 超过上限的间隔视为指令流中断, 不计入
+    const int64_t dt = arrival_ns - last_arrival_ns_;
+    last_arrival_ns_ = arrival_ns;
+    if (dt > 0 && dt <= max_interval_ns_)
+        interval_ns_ = interval_ns_ == 0 ? dt : interval_ns_ + (dt - interval_ns_) / 8;
+    interval_stat_ns_.store(interval_ns_, std::memory_order_relaxed);
+
+    // 新一段从上一次输出出发, 设定值连续
+    std::memcpy(p0_, out_p_, sizeof(p0_));
+    std::memcpy(v0_, out_v_, sizeof(v0_));
+    std::memcpy(p1_, position, sizeof(p1_));
+    if (config_.mode == InterpolationMode::kCubic)
+        std::memcpy(v1_, velocity, sizeof(v1_));
+    else
+        std::memset(v1_, 0, sizeof(v1_));
+    start_ns_ = start_ns;
+    duration_ns_ = std::min(std::max(interval_ns_, min_interval_ns_), max_interval_ns_);
+    return true;
+}
+
+bool CommandInterpolator::Sample(int64_t now_ns, double *position)
+{
+    if (!primed_)
+        return false;
+    samples_.fetch_add(1, std::memory_order_relaxed);
+
+    if (config_.mode == InterpolationMode::kHold) {
+        std::memcpy(position, p1_, sizeof(p1_));
+        std::memcpy(out_p_, p1_, sizeof(out_p_));
+        return true;
+    }
+
+    const double T = duration_ns_ * 1e-9;
+    const int64_t t_ns = std::max<int64_t>(now_ns - start_ns_, 0);
+
+    if (t_ns <= duration_ns_) {
+        const double s = (double)t_ns / (double)duration_ns_;
+        const double s2 = s * s, s3 = s2 * s;
+
+        switch (config_.mode) {
+        case InterpolationMode::kLinear:
+            for (int i = 0; i < kNumCommandJoints; ++i) {
+                out_p_[i] = p0_[i] + (p1_[i] - p0_[i]) * s;
+                out_v_[i] = (p1_[i] - p0_[i]) / T;
+            }
+            break;
+        case InterpolationMode::kCubic: {
+            // Hermite 基函数, 端点速度乘以段长换算到 s 域
+            const double h00 = 2 * s3 - 3 * s2 + 1, h10 = s3 - 2 * s2 + s;
+            const double h01 = -2 * s3 + 3 * s2, h11 = s3 - s2;
+            const double d00 = 6 * s2 - 6 * s, d10 = 3 * s2 - 4 * s + 1;
+            const double d01 = -6 * s2 + 6 * s, d11 = 3 * s2 - 2 * s;
+            for (int i = 0; i < kNumCommandJoints; ++i) {
+                out_p_[i] = h00 * p0_[i] + h10 * T * v0_[i] + h01 * p1_[i] + h11 * T * v1_[i];
+                out_v_[i] = (d00 * p0_[i] + d01 * p1_[i]) / T + d10 * v0_[i] + d11 * v1_[i];
+            }
+            break;
+        }
+        case InterpolationMode::kMinJerk: {
+            // 两端速度、加速度为零
+            const double b = s3 * (10 - 15 * s + 6 * s2);
+            const double db = 30 * s2 * (1 - 2 * s + s2);
+            for (int i = 0; i < kNumCommandJoints; ++i) {
+                out_p_[i] = p0_[i] + (p1_[i] - p0_[i]) * b;
+                out_v_[i] = (p1_[i] - p0_[i]) * db / T;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    } else {
+        // 指令迟到: 沿末端速度外推, 超过上限后停在外推终点
+        int64_t over_ns = t_ns - duration_ns_;
+        const bool hold = over_ns > extrapolate_ns_;
+        if (hold) {
+            over_ns = extrapolate_ns_;
+            held_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            extrapolated_.fetch_add(1, std::memory_order_relaxed);
+        }
+        const double over = over_ns * 1e-9;
+
+        for (int i = 0; i < kNumCommandJoints; ++i) {
+            double v_end = 0.0;
+            if (config_.mode == InterpolationMode::kLinear)
+                v_end = (p1_[i] - p0_[i]) / T;
+            else if (config_.mode == InterpolationMode::kCubic)
+                v_end = v1_[i];
+            out_p_[i] = p1_[i] + v_end * over;
+            out_v_[i] = hold ? 0.0 : v_end;
+        }
+    }
+
+    std::memcpy(position, out_p_, sizeof(out_p_));
+    return true;
+}
+
+CommandInterpolatorStats CommandInterpolator::GetStats() const
+{
+    CommandInterpolatorStats stats;
+    stats.commands = commands_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    stats.samples = samples_.load(std::memory_order_relaxed);
+    stats.extrapolated = extrapolated_.load(std::memory_order_relaxed);
+    stats.held = held_.load(std::memory_order_relaxed);
+    stats.interval_ns = interval_stat_ns_.load(std::memory_order_relaxed);
+    return stats;
+}
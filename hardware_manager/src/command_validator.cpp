@@ -0,0 +1,199 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#include "command_validator.h"
+#include "rt_time.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static_assert(kNumCommandJoints % 2 == 0, "limits are compared two lanes at a time");
+
+namespace {
+
+const char *const kLegNames[4] = {"FR", "FL", "RR", "RL"};
+const char *const kFieldNames[3] = {"position", "kp", "kd"};
+
+// 第 i 位: x[i] 不在 [lo[i], hi[i]] 内, NaN 视为超限
+uint16_t OutOfRangeMask(const double *x, const double *lo, const double *hi)
+{
+    uint32_t mask = 0;
+#if defined(__SSE2__)
+    for (int i = 0; i < kNumCommandJoints; i += 2) {
+        const __m128d v = _mm_loadu_pd(x + i);
+        const __m128d in = _mm_and_pd(_mm_cmpge_pd(v, _mm_load_pd(lo + i)), _mm_cmple_pd(v, _mm_load_pd(hi + i)));
+        mask |= (uint32_t)(~_mm_movemask_pd(in) & 0x3) << i;
+    }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    for (int i = 0; i < kNumCommandJoints; i += 2) {
+        const float64x2_t v = vld1q_f64(x + i);
+        const uint64x2_t in = vandq_u64(vcgeq_f64(v, vld1q_f64(lo + i)), vcleq_f64(v, vld1q_f64(hi + i)));
+        mask |= (uint32_t)((~vgetq_lane_u64(in, 0) & 1) | ((~vgetq_lane_u64(in, 1) & 1) << 1)) << i;
+    }
+#else
+    for (int i = 0; i < kNumCommandJoints; ++i)
+        mask |= (uint32_t)!(x[i] >= lo[i] && x[i] <= hi[i]) << i;
+#endif
+    return (uint16_t)mask;
+}
+
+// 第 i 位: x[i] 为 NaN 或 Inf (x * 0 不等于 0)
+uint16_t NonFiniteMask(const double *x)
+{
+    uint32_t mask = 0;
+#if defined(__SSE2__)
+    const __m128d zero = _mm_setzero_pd();
+    for (int i = 0; i < kNumCommandJoints; i += 2) {
+        const __m128d v = _mm_loadu_pd(x + i);
+        mask |= (uint32_t)(~_mm_movemask_pd(_mm_cmpeq_pd(_mm_mul_pd(v, zero), zero)) & 0x3) << i;
+    }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    const float64x2_t zero = vdupq_n_f64(0.0);
+    for (int i = 0; i < kNumCommandJoints; i += 2) {
+        const uint64x2_t finite = vceqq_f64(vmulq_f64(vld1q_f64(x + i), zero), zero);
+        mask |= (uint32_t)((~vgetq_lane_u64(finite, 0) & 1) | ((~vgetq_lane_u64(finite, 1) & 1) << 1)) << i;
+    }
+#else
+    for (int i = 0; i < kNumCommandJoints; ++i)
+        mask |= (uint32_t)!(x[i] * 0.0 == 0.0) << i;
+#endif
+    return (uint16_t)mask;
+}
+
+// x = min(max(x, lo), hi), 调用前已排除非有限值
+void Clamp(double *x, const double *lo, const double *hi)
+{
+#if defined(__SSE2__)
+    for (int i = 0; i < kNumCommandJoints; i += 2)
+        _mm_storeu_pd(x + i, _mm_min_pd(_mm_max_pd(_mm_loadu_pd(x + i), _mm_load_pd(lo + i)), _mm_load_pd(hi + i)));
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    for (int i = 0; i < kNumCommandJoints; i += 2)
+        vst1q_f64(x + i, vminq_f64(vmaxq_f64(vld1q_f64(x + i), vld1q_f64(lo + i)), vld1q_f64(hi + i)));
+#else
+    for (int i = 0; i < kNumCommandJoints; ++i)
+        x[i] = x[i] < lo[i] ? lo[i] : (x[i] > hi[i] ? hi[i] : x[i]);
+#endif
+}
+
+} // namespace
+
+CommandValidator::CommandValidator()
+{
+    // NaN 限位使任何比较都不成立
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (Limits *limits : {&position_, &kp_, &kd_}) {
+        std::fill(std::begin(limits->min), std::end(limits->min), nan);
+        std::fill(std::begin(limits->max), std::end(limits->max), nan);
+    }
+}
+
+/// @brief 按 Matrix3x4d 列优先顺序展开: 每条腿 (列) 依次为 小腿, 大腿, 髋
+void CommandValidator::SetLimits(const ControlLimits &control, const LegJointLimitsMap &joints)
+{
+    for (int col = 0; col < 4; ++col) {
+        const auto it = joints.find(kLegNames[col]);
+        for (int row = 0; row < 3; ++row) {
+            const int i = col * 3 + row;
+            if (it != joints.end()) {
+                const JointLimit &limit = row == 2 ? it->second.hip : (row == 1 ? it->second.thigh : it->second.calf);
+                position_.min[i] = limit.min;
+                position_.max[i] = limit.max;
+            }
+            kp_.min[i] = control.kp_min;
+            kp_.max[i] = control.kp_max;
+            kd_.min[i] = control.kd_min;
+            kd_.max[i] = control.kd_max;
+        }
+    }
+    mode_ = control.violation_mode;
+}
+
+LimitViolation CommandValidator::Check(const double *position, const double *kp, const double *kd) const
+{
+    LimitViolation v;
+    v.position = OutOfRangeMask(position, position_.min, position_.max);
+    v.kp = OutOfRangeMask(kp, kp_.min, kp_.max);
+    v.kd = OutOfRangeMask(kd, kd_.min, kd_.max);
+    v.non_finite = NonFiniteMask(position) | NonFiniteMask(kp) | NonFiniteMask(kd);
+    return v;
+}
+
+bool CommandValidator::Apply(double *position, double *kp, double *kd)
+{
+    checked_.fetch_add(1, std::memory_order_relaxed);
+
+    const LimitViolation v = Check(position, kp, kd);
+    if (!v.any())
+        return true;
+
+    // 第一个超限项, 仅用于报告
+    LimitViolationReport report;
+    report.t_ns = MonotonicNowNs();
+    report.violation = v;
+    const uint16_t masks[3] = {v.position, v.kp, v.kd};
+    const double *values[3] = {position, kp, kd};
+    const Limits *limits[3] = {&position_, &kp_, &kd_};
+    report.field = masks[0] ? 0 : (masks[1] ? 1 : 2);
+    report.index = (uint8_t)__builtin_ctz(masks[report.field]);
+    report.value = values[report.field][report.index];
+    report.min = limits[report.field]->min[report.index];
+    report.max = limits[report.field]->max[report.index];
+
+    report.rejected = mode_ == LimitViolationMode::kReject || v.non_finite != 0;
+    if (report.rejected) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        Clamp(position, position_.min, position_.max);
+        Clamp(kp, kp_.min, kp_.max);
+        Clamp(kd, kd_.min, kd_.max);
+        clamped_.fetch_add(1, std::memory_order_relaxed);
+        clamped_values_.fetch_add(__builtin_popcount(v.position) + __builtin_popcount(v.kp) + __builtin_popcount(v.kd),
+                                  std::memory_order_relaxed);
+    }
+
+    reports_.push(report);
+    return !report.rejected;
+}
+
+void CommandValidator::DrainReports(std::ostream &os)
+{
+    LimitViolationReport report;
+    while (reports_.pop(report)) {
+        if (repeats_ > 0 && report.violation == last_reported_) {
+            ++repeats_;
+            continue;
+        }
+        if (repeats_ > 1)
+            os << "[WARN] previous limit violation repeated " << repeats_ - 1 << " more times\n";
+
+        const int row = report.index % 3, col = report.index / 3;
+        char line[200];
+        std::snprintf(line, sizeof(line),
+                      "[ERROR] Invalid %s (%g) at [%d, %d] (%s), limit: [%g, %g], masks pos/kp/kd = %03X/%03X/%03X -> %s\n",
+                      kFieldNames[report.field], report.value, row, col, kLegNames[col], report.min, report.max,
+                      report.violation.position, report.violation.kp, report.violation.kd,
+                      report.rejected ? "rejected" : "clamped");
+        os << line;
+
+        last_reported_ = report.violation;
+        repeats_ = 1;
+    }
+}
+
+CommandValidatorStats CommandValidator::GetStats() const
+{
+    CommandValidatorStats stats;
+    stats.checked = checked_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    stats.clamped = clamped_.load(std::memory_order_relaxed);
+    stats.clamped_values = clamped_values_.load(std::memory_order_relaxed);
+    stats.reports_dropped = reports_.dropped();
+    return stats;
+}
@@ -0,0 +1,366 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#include "flight_recorder.h"
+#include "rt_time.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// 供信号处理函数使用, 同一进程内只有一个记录器生效
+std::atomic<FlightRecorder *> g_fault_recorder{nullptr};
+
+uint64_t RoundUpPow2(uint64_t n)
+{
+    uint64_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+int64_t RealtimeNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// 写满 size 字节, 只用 write(2), 可在信号处理函数中调用
+bool WriteAll(int fd, const void *buf, size_t size)
+{
+    const char *p = (const char *)buf;
+    while (size > 0) {
+        const ssize_t n = write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+// 复制一条已写完的记录, 复制前后序号一致才算有效
+bool ReadRecord(const FlightRecord &src, uint64_t idx, FlightRecord &dst)
+{
+    const uint32_t expect = (uint32_t)(idx + 1);
+    if (src.seq.load(std::memory_order_acquire) != expect)
+        return false;
+    dst.t_ns = src.t_ns;
+    dst.id = src.id;
+    dst.type = src.type;
+    dst.channel = src.channel;
+    std::memcpy(dst.payload, src.payload, kFlightPayloadSize);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (src.seq.load(std::memory_order_relaxed) != expect)
+        return false;
+    dst.seq.store(expect, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace
+
+FlightRecorder::~FlightRecorder()
+{
+    Close();
+}
+
+/// @brief 建立记录文件: 文件头 + 各环依次排列, 全部页预先写零, 运行期不再缺页
+bool FlightRecorder::Open(const FlightRecorderConfig &config)
+{
+    Close();
+
+    const uint64_t capacity[kFlightNumStreams] = {
+        RoundUpPow2((uint64_t)std::max(config.tx_records, 1)),
+        RoundUpPow2((uint64_t)std::max(config.rx_records, 1)),
+        RoundUpPow2((uint64_t)std::max(config.lowcmd_records, 1)),
+        RoundUpPow2((uint64_t)std::max(config.imu_records, 1)),
+    };
+
+    size_t size = kFlightHeaderSize;
+    for (uint64_t c : capacity)
+        size += c * sizeof(FlightRecord);
+
+    // 保留上一次运行的记录, 崩溃后重启不会覆盖待查看的现场
+    const std::string prev_path = config.path + ".prev";
+    if (rename(config.path.c_str(), prev_path.c_str()) == 0)
+        std::cout << "[INFO] Previous flight recorder file kept as " << prev_path << std::endl;
+    else if (errno != ENOENT)
+        std::cerr << "[WARN] Failed to keep previous flight recorder file: " << strerror(errno) << std::endl;
+
+    const int fd = open(config.path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[ERROR] Failed to open flight recorder file " << config.path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        std::cerr << "[ERROR] Failed to size flight recorder file: " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+    // 预先分配磁盘块, 避免运行中写到文件空洞时分配; 不支持的文件系统忽略
+    posix_fallocate(fd, 0, (off_t)size);
+
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "[ERROR] Failed to map flight recorder file: " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::memset(map, 0, size); // 逐页写入, 预取页表并标记为脏页
+
+    header_ = (FlightFileHeader *)map;
+    map_size_ = size;
+
+    std::memcpy(header_->magic, kFlightMagic, sizeof(kFlightMagic));
+    header_->version = kFlightVersion;
+    header_->record_size = sizeof(FlightRecord);
+    header_->num_streams = kFlightNumStreams;
+    header_->start_monotonic_ns = MonotonicNowNs();
+    header_->start_realtime_ns = RealtimeNowNs();
+
+    uint64_t offset = kFlightHeaderSize;
+    for (int s = 0; s < kFlightNumStreams; ++s) {
+        FlightStreamHeader &stream = header_->streams[s];
+        stream.offset = offset;
+        stream.capacity = capacity[s];
+        stream.head.store(0, std::memory_order_relaxed);
+        streams_[s] = (FlightRecord *)((char *)map + offset);
+        masks_[s] = capacity[s] - 1;
+        offset += capacity[s] * sizeof(FlightRecord);
+    }
+
+    std::snprintf(dump_path_, sizeof(dump_path_), "%s", config.dump_path.c_str());
+    dump_window_ns_ = (int64_t)(std::max(config.dump_seconds, 0.0) * 1e9);
+
+    std::cout << "[INFO] Flight recorder: " << config.path << " (" << (size >> 20) << " MiB)" << std::endl;
+    return true;
+}
+
+void FlightRecorder::Close()
+{
+    FlightRecorder *self = this;
+    g_fault_recorder.compare_exchange_strong(self, nullptr);
+
+    if (header_) {
+        munmap(header_, map_size_);
+        header_ = nullptr;
+    }
+    std::fill(std::begin(streams_), std::end(streams_), nullptr);
+    map_size_ = 0;
+}
+
+/// @brief 领取槽位 -> 序号清零 -> 写入内容 -> 以 release 写入序号; 读者以序号判断记录是否完整
+void FlightRecorder::Append(FlightStream stream, FlightRecordType type, uint8_t channel, uint32_t id,
+                            const void *payload, size_t size, int64_t t_ns)
+{
+    if (!header_ || stream >= kFlightNumStreams)
+        return;
+
+    const uint64_t idx = header_->streams[stream].head.fetch_add(1, std::memory_order_relaxed);
+    FlightRecord &rec = streams_[stream][idx & masks_[stream]];
+
+    rec.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    rec.t_ns = t_ns;
+    rec.id = (uint16_t)id;
+    rec.type = type;
+    rec.channel = channel;
+    size = std::min(size, kFlightPayloadSize);
+    std::memcpy(rec.payload, payload, size);
+    std::memset(rec.payload + size, 0, kFlightPayloadSize - size);
+
+    rec.seq.store((uint32_t)(idx + 1), std::memory_order_release);
+}
+
+/// @brief 各环最近 window_ns 内的记录按时间顺序写出, 输出文件各环不再回绕 (head == capacity)
+bool FlightRecorder::DumpRecent(const char *path, int64_t window_ns, int64_t end_ns) const
+{
+    if (!header_ || !path || !path[0])
+        return false;
+
+    const int64_t since_ns = (end_ns ? end_ns : MonotonicNowNs()) - window_ns;
+
+    // 先统计各环在窗口内的有效记录区间 [first, head)
+    uint64_t first[kFlightNumStreams], last[kFlightNumStreams];
+    for (int s = 0; s < kFlightNumStreams; ++s) {
+        const uint64_t head = header_->streams[s].head.load(std::memory_order_acquire);
+        const uint64_t capacity = masks_[s] + 1;
+        uint64_t begin = head > capacity ? head - capacity : 0;
+
+        // 时间单调, 二分查找窗口起点
+        uint64_t lo = begin, hi = head;
+        while (lo < hi) {
+            const uint64_t mid = lo + (hi - lo) / 2;
+            if (streams_[s][mid & masks_[s]].t_ns < since_ns)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        first[s] = lo;
+        last[s] = head;
+    }
+
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+
+    // 文件头: 各环容量即导出条数, 复制时已被覆盖的记录 seq 为 0, 解码时跳过
+    alignas(64) char header_buf[kFlightHeaderSize] = {};
+    FlightFileHeader *out = (FlightFileHeader *)header_buf;
+    std::memcpy(out->magic, header_->magic, sizeof(out->magic));
+    out->version = header_->version;
+    out->record_size = header_->record_size;
+    out->num_streams = header_->num_streams;
+    out->start_monotonic_ns = header_->start_monotonic_ns;
+    out->start_realtime_ns = header_->start_realtime_ns;
+
+    uint64_t offset = kFlightHeaderSize;
+    for (int s = 0; s < kFlightNumStreams; ++s) {
+        const uint64_t count = last[s] - first[s];
+        out->streams[s].offset = offset;
+        out->streams[s].capacity = count;
+        out->streams[s].head.store(count, std::memory_order_relaxed);
+        offset += count * sizeof(FlightRecord);
+    }
+
+    bool ok = WriteAll(fd, header_buf, sizeof(header_buf));
+
+    // 逐块复制校验后写出, 重新编号为输出文件内的序号
+    constexpr int kChunk = 64;
+    FlightRecord chunk[kChunk];
+    for (int s = 0; s < kFlightNumStreams && ok; ++s) {
+        int n = 0;
+        for (uint64_t idx = first[s]; idx < last[s] && ok; ++idx) {
+            FlightRecord &dst = chunk[n];
+            if (ReadRecord(streams_[s][idx & masks_[s]], idx, dst))
+                dst.seq.store((uint32_t)(idx - first[s] + 1), std::memory_order_relaxed);
+            else
+                std::memset((void *)&dst, 0, sizeof(dst)); // 已被覆盖或正在写
+            if (++n == kChunk) {
+                ok = WriteAll(fd, chunk, sizeof(chunk));
+                n = 0;
+            }
+        }
+        if (ok && n > 0)
+            ok = WriteAll(fd, chunk, n * sizeof(FlightRecord));
+    }
+
+    close(fd);
+    return ok;
+}
+
+bool FlightRecorder::DumpConfigured(int64_t end_ns) const
+{
+    const bool ok = DumpRecent(dump_path_, dump_window_ns_, end_ns);
+    if (ok)
+        std::cout << "[INFO] Flight recorder dumped to " << dump_path_ << std::endl;
+    return ok;
+}
+
+void FlightRecorder::InstallFaultHandlers()
+{
+    if (!header_)
+        return;
+    g_fault_recorder.store(this, std::memory_order_release);
+
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = &FlightRecorder::FaultHandler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESETHAND | SA_NODEFER; // 处理一次后恢复默认动作
+
+    for (int sig : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT})
+        sigaction(sig, &sa, nullptr);
+}
+
+/// @brief 导出后重新发出同一信号, 按默认动作结束进程 (保留 core dump)
+void FlightRecorder::FaultHandler(int sig)
+{
+    FlightRecorder *recorder = g_fault_recorder.exchange(nullptr);
+    if (recorder)
+        recorder->DumpRecent(recorder->dump_path_, recorder->dump_window_ns_);
+    raise(sig);
+}
+
+/*********************************       *** LoadFlightTrace ***      ***********************************************/
+
+bool LoadFlightTrace(const std::string &path, FlightTrace &trace)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "[ERROR] Cannot open flight trace " << path << std::endl;
+        return false;
+    }
+    std::vector<char> raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // 复制到按64字节对齐的缓冲区后再按记录访问
+    std::vector<FlightRecord> buffer((raw.size() + sizeof(FlightRecord) - 1) / sizeof(FlightRecord));
+    std::memcpy((void *)buffer.data(), raw.data(), raw.size());
+    const char *base = (const char *)buffer.data();
+
+    if (raw.size() < sizeof(FlightFileHeader)) {
+        std::cerr << "[ERROR] Flight trace too small: " << path << std::endl;
+        return false;
+    }
+    const FlightFileHeader &header = *(const FlightFileHeader *)base;
+    if (std::memcmp(header.magic, kFlightMagic, sizeof(kFlightMagic)) != 0 || header.version != kFlightVersion ||
+        header.record_size != sizeof(FlightRecord) || header.num_streams != kFlightNumStreams) {
+        std::cerr << "[ERROR] Not a flight recorder file (or unsupported version): " << path << std::endl;
+        return false;
+    }
+
+    trace.start_monotonic_ns = header.start_monotonic_ns;
+    trace.start_realtime_ns = header.start_realtime_ns;
+    trace.events.clear();
+
+    // seq 非0即为完整记录 (写到一半时 seq 为0)
+    for (int s = 0; s < kFlightNumStreams; ++s) {
+        const FlightStreamHeader &stream = header.streams[s];
+        if (stream.offset + stream.capacity * sizeof(FlightRecord) > raw.size()) {
+            std::cerr << "[WARN] Flight trace stream " << s << " truncated, skipped" << std::endl;
+            continue;
+        }
+
+        const uint64_t count = std::min(stream.head.load(std::memory_order_relaxed), stream.capacity);
+        const FlightRecord *records = (const FlightRecord *)(base + stream.offset);
+        for (uint64_t i = 0; i < count; ++i) {
+            const FlightRecord &r = records[i];
+            const uint32_t seq = r.seq.load(std::memory_order_relaxed);
+            if (seq == 0)
+                continue;
+            FlightEvent e;
+            e.t_ns = r.t_ns;
+            e.seq = seq;
+            e.stream = (uint8_t)s;
+            e.type = r.type;
+            e.channel = r.channel;
+            e.id = r.id;
+            std::memcpy(e.payload, r.payload, kFlightPayloadSize);
+            trace.events.push_back(e);
+        }
+    }
+
+    // 同一时刻的记录按环、再按环内写入顺序排列
+    std::sort(trace.events.begin(), trace.events.end(), [](const FlightEvent &a, const FlightEvent &b) {
+        if (a.t_ns != b.t_ns)
+            return a.t_ns < b.t_ns;
+        if (a.stream != b.stream)
+            return a.stream < b.stream;
+        return a.seq < b.seq;
+    });
+    return true;
+}
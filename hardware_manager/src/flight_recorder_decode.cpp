@@ -0,0 +1,103 @@
+// Copyright (c) 2023–2025 TANGAIR
+// SPDX-License-Identifier: Apache-2.0
+
+// 飞行记录文件解码, 各环记录按时间合并后逐行输出文本
+// 用法: ./reddog_flight_decode <file> [--since-seconds N]
+//   file 可以是运行中的记录文件 (path) 或导出文件 (dump_path)
+//   --since-seconds 只输出最后 N 秒
+
+#include "flight_recorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+void PrintFloats(const uint8_t *payload, int n)
+{
+    float v[12];
+    std::memcpy(v, payload, n * sizeof(float));
+    for (int i = 0; i < n; ++i)
+        std::printf(" %.4f", v[i]);
+}
+
+void PrintEvent(const FlightEvent &e, int64_t t0_ns)
+{
+    std::printf("%12.6f ", (e.t_ns - t0_ns) * 1e-9);
+
+    switch (e.type) {
+    case kFlightRecordTxFrame:
+    case kFlightRecordRxFrame:
+        if (FlightAdapter(e.channel) != 0)
+            std::printf("%s dev%d ch%d id=0x%03X data=", e.type == kFlightRecordTxFrame ? "TX " : "RX ",
+                        FlightAdapter(e.channel), FlightBusChannel(e.channel), e.id);
+        else
+            std::printf("%s ch%u id=0x%03X data=", e.type == kFlightRecordTxFrame ? "TX " : "RX ", e.channel, e.id);
+        for (int i = 0; i < 8; ++i)
+            std::printf("%02X", e.payload[i]);
+        break;
+    case kFlightRecordLowCmdQ:
+        std::printf("CMD q  ");
+        PrintFloats(e.payload, 12);
+        break;
+    case kFlightRecordLowCmdKp:
+        std::printf("CMD kp ");
+        PrintFloats(e.payload, 12);
+        break;
+    case kFlightRecordLowCmdKd:
+        std::printf("CMD kd ");
+        PrintFloats(e.payload, 12);
+        break;
+    case kFlightRecordImu: {
+        uint32_t counter;
+        std::memcpy(&counter, e.payload + 10 * sizeof(float), sizeof(counter));
+        std::printf("IMU #%u quat", counter);
+        PrintFloats(e.payload, 4);
+        std::printf(" gyr");
+        PrintFloats(e.payload + 4 * sizeof(float), 3);
+        std::printf(" acc");
+        PrintFloats(e.payload + 7 * sizeof(float), 3);
+        break;
+    }
+    default:
+        std::printf("UNKNOWN type=%u stream=%u", e.type, e.stream);
+        break;
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <file> [--since-seconds N]\n", argv[0]);
+        return 1;
+    }
+
+    double since_seconds = -1.0;
+    for (int i = 2; i + 1 < argc; ++i)
+        if (std::strcmp(argv[i], "--since-seconds") == 0)
+            since_seconds = std::atof(argv[++i]);
+
+    FlightTrace trace;
+    if (!LoadFlightTrace(argv[1], trace))
+        return 1;
+
+    std::vector<FlightEvent> &events = trace.events;
+    if (since_seconds >= 0.0 && !events.empty()) {
+        const int64_t since_ns = events.back().t_ns - (int64_t)(since_seconds * 1e9);
+        events.erase(events.begin(),
+                     std::lower_bound(events.begin(), events.end(), since_ns,
+                                      [](const FlightEvent &e, int64_t t) { return e.t_ns < t; }));
+    }
+
+    // 时间以记录器启动为零点, 同时给出墙钟时间
+    std::printf("# start_realtime_ns=%lld records=%zu\n", (long long)trace.start_realtime_ns, events.size());
+    for (const FlightEvent &e : events)
+        PrintEvent(e, trace.start_monotonic_ns);
+    return 0;
+}
@@ -0,0 +1,104 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#include "io_reactor.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// 控制 eventfd 的 epoll 标记, 不与 handlers_ 下标冲突
+static constexpr uint64_t kControlTag = ~0ull;
+
+IoReactor::~IoReactor()
+{
+    Close();
+}
+
+bool IoReactor::Open()
+{
+    Close();
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    control_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || control_fd_ < 0) {
+        std::cerr << "[ERROR] io_reactor: 创建 epoll / eventfd 失败: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = kControlTag;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, control_fd_, &ev) < 0) {
+        std::cerr << "[ERROR] io_reactor: 登记控制 eventfd 失败: " << strerror(errno) << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void IoReactor::Close()
+{
+    if (epoll_fd_ >= 0)
+        close(epoll_fd_);
+    if (control_fd_ >= 0)
+        close(control_fd_);
+    epoll_fd_ = -1;
+    control_fd_ = -1;
+    handlers_.clear();
+}
+
+bool IoReactor::Add(int fd, Handler handler)
+{
+    if (epoll_fd_ < 0 || fd < 0)
+        return false;
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = handlers_.size();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        std::cerr << "[ERROR] io_reactor: 登记 fd " << fd << " 失败: " << strerror(errno) << std::endl;
+        return false;
+    }
+    handlers_.push_back(std::move(handler));
+    return true;
+}
+
+void IoReactor::Run()
+{
+    struct epoll_event events[kMaxEvents];
+
+    while (true) {
+        const int n = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "[ERROR] io_reactor: epoll_wait 失败: " << strerror(errno) << std::endl;
+            return;
+        }
+        wakeups_.fetch_add(1, std::memory_order_relaxed);
+
+        for (int i = 0; i < n; ++i) {
+            const uint64_t tag = events[i].data.u64;
+            if (tag == kControlTag) {
+                uint64_t value = 0;
+                (void)!read(control_fd_, &value, sizeof(value));
+                return;
+            }
+            handlers_[tag]();
+        }
+        dispatches_.fetch_add(n, std::memory_order_relaxed);
+    }
+}
+
+void IoReactor::Stop()
+{
+    if (control_fd_ < 0)
+        return;
+    const uint64_t one = 1;
+    (void)!write(control_fd_, &one, sizeof(one));
+}
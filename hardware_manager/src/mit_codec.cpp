@@ -0,0 +1,131 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#include "mit_codec.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static_assert(kMitBatchSize % 4 == 0, "MIT batch is processed four lanes at a time");
+
+namespace {
+
+// out[i] = trunc((clamp(x[i], lo[i], hi[i]) - lo[i]) * enc[i]), NaN 按下限处理
+void Quantize(const float *x, const float *lo, const float *hi, const float *enc, int32_t *out)
+{
+#if defined(__SSE2__)
+    for (int i = 0; i < kMitBatchSize; i += 4) {
+        const __m128 l = _mm_load_ps(lo + i);
+        __m128 v = _mm_max_ps(_mm_load_ps(x + i), l); // x 为 NaN 时取 l
+        v = _mm_min_ps(v, _mm_load_ps(hi + i));
+        v = _mm_mul_ps(_mm_sub_ps(v, l), _mm_load_ps(enc + i));
+        _mm_storeu_si128((__m128i *)(out + i), _mm_cvttps_epi32(v));
+    }
+#elif defined(__ARM_NEON)
+    for (int i = 0; i < kMitBatchSize; i += 4) {
+        const float32x4_t l = vld1q_f32(lo + i);
+        float32x4_t v = vminq_f32(vmaxq_f32(vld1q_f32(x + i), l), vld1q_f32(hi + i));
+        v = vmulq_f32(vsubq_f32(v, l), vld1q_f32(enc + i));
+        vst1q_s32(out + i, vcvtq_s32_f32(v)); // NaN 转换为 0
+    }
+#else
+    for (int i = 0; i < kMitBatchSize; ++i) {
+        float v = x[i] > lo[i] ? x[i] : lo[i];
+        v = v < hi[i] ? v : hi[i];
+        out[i] = (int32_t)((v - lo[i]) * enc[i]);
+    }
+#endif
+}
+
+// out[i] = q[i] * dec[i] + lo[i]
+void Dequantize(const int32_t *q, const float *lo, const float *dec, float *out)
+{
+#if defined(__SSE2__)
+    for (int i = 0; i < kMitBatchSize; i += 4) {
+        const __m128 v = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(q + i)));
+        _mm_store_ps(out + i, _mm_add_ps(_mm_mul_ps(v, _mm_load_ps(dec + i)), _mm_load_ps(lo + i)));
+    }
+#elif defined(__ARM_NEON)
+    for (int i = 0; i < kMitBatchSize; i += 4) {
+        const float32x4_t v = vcvtq_f32_s32(vld1q_s32(q + i));
+        vst1q_f32(out + i, vmlaq_f32(vld1q_f32(lo + i), v, vld1q_f32(dec + i)));
+    }
+#else
+    for (int i = 0; i < kMitBatchSize; ++i)
+        out[i] = (float)q[i] * dec[i] + lo[i];
+#endif
+}
+
+} // namespace
+
+void MitBatchCodec::FieldScale::Set(int i, float min, float max, int bits)
+{
+    const float levels = (float)((1 << bits) - 1);
+    lo[i] = min;
+    hi[i] = max;
+    enc[i] = levels / (max - min);
+    dec[i] = (max - min) / levels;
+}
+
+MitBatchCodec::MitBatchCodec()
+{
+    for (int i = 0; i < kMitBatchSize; ++i) {
+        position_.Set(i, P_MIN, P_MAX, 16);
+        velocity_.Set(i, V_MIN, V_MAX, 12);
+        kp_.Set(i, KP_MIN, KP_MAX, 12);
+        kd_.Set(i, KD_MIN, KD_MAX, 12);
+        torque_.Set(i, T_MIN_8006, T_MAX_8006, 12);
+    }
+}
+
+void MitBatchCodec::SetTorqueLimits(int i, float tau_min, float tau_max)
+{
+    if (i >= 0 && i < kMitBatchSize)
+        torque_.Set(i, tau_min, tau_max, 12);
+}
+
+/// @brief 与 CAN_Send_Control 的打包格式一致, 定点化用预先算好的倒数比例代替除法
+void MitBatchCodec::Encode(const MitCommandBatch &cmd, uint8_t (*payloads)[8]) const
+{
+    alignas(16) int32_t p[kMitBatchSize], v[kMitBatchSize], kp[kMitBatchSize], kd[kMitBatchSize], t[kMitBatchSize];
+
+    Quantize(cmd.position, position_.lo, position_.hi, position_.enc, p);
+    Quantize(cmd.velocity, velocity_.lo, velocity_.hi, velocity_.enc, v);
+    Quantize(cmd.kp, kp_.lo, kp_.hi, kp_.enc, kp);
+    Quantize(cmd.kd, kd_.lo, kd_.hi, kd_.enc, kd);
+    Quantize(cmd.torque, torque_.lo, torque_.hi, torque_.enc, t);
+
+    for (int i = 0; i < kMitBatchSize; ++i) {
+        uint8_t *d = payloads[i];
+        d[0] = (uint8_t)(p[i] >> 8);
+        d[1] = (uint8_t)p[i];
+        d[2] = (uint8_t)(v[i] >> 4);
+        d[3] = (uint8_t)(((v[i] & 0xF) << 4) | (kp[i] >> 8));
+        d[4] = (uint8_t)kp[i];
+        d[5] = (uint8_t)(kd[i] >> 4);
+        d[6] = (uint8_t)(((kd[i] & 0xF) << 4) | (t[i] >> 8));
+        d[7] = (uint8_t)t[i];
+    }
+}
+
+/// @brief 与 CAN_RX_Decode 的解析格式一致
+void MitBatchCodec::Decode(const uint8_t (*payloads)[8], MitFeedbackBatch &fb) const
+{
+    alignas(16) int32_t p[kMitBatchSize], v[kMitBatchSize], t[kMitBatchSize];
+
+    for (int i = 0; i < kMitBatchSize; ++i) {
+        const uint8_t *d = payloads[i];
+        fb.err[i] = d[0] >> 4;
+        p[i] = (d[1] << 8) | d[2];
+        v[i] = (d[3] << 4) | (d[4] >> 4);
+        t[i] = ((d[4] & 0xF) << 8) | d[5];
+        fb.temp_mos[i] = d[6];
+        fb.temp_rotor[i] = d[7];
+    }
+
+    Dequantize(p, position_.lo, position_.dec, fb.position);
+    Dequantize(v, velocity_.lo, velocity_.dec, fb.velocity);
+    Dequantize(t, torque_.lo, torque_.dec, fb.torque);
+}
@@ -0,0 +1,244 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#include "motor_bus_emulator.h"
+#include "rt_time.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// 与 CAN_Send_Control / CAN_RX_Decode 相反方向的定点换算
+float ToFloat(int x_int, float x_min, float x_max, int bits)
+{
+    return (float)x_int * (x_max - x_min) / (float)((1 << bits) - 1) + x_min;
+}
+
+int ToUint(double x, float x_min, float x_max, int bits)
+{
+    x = std::min<double>(std::max<double>(x, x_min), x_max);
+    return (int)((x - x_min) * (double)((1 << bits) - 1) / (x_max - x_min));
+}
+
+bool IsSpecialCommand(const uint8_t *data)
+{
+    for (int i = 0; i < 7; ++i)
+        if (data[i] != 0xFF)
+            return false;
+    return true;
+}
+
+} // namespace
+
+MotorBusEmulator::MotorBusEmulator(const CanEmulatorConfig &config)
+    : config_(config),
+      frame_time_ns_((int64_t)CAN_FRAME_BITS_MAX * 1000000000LL / std::max(config.bitrate, 1)),
+      rng_(config.seed)
+{
+    // 与 USB2CAN_CAN_Bus_inti_set 一致: ID 3/7 为 DM8009, 其余为 DM8006
+    for (auto &channel : joints_) {
+        channel[3].tau_min = channel[7].tau_min = T_MIN_8009;
+        channel[3].tau_max = channel[7].tau_max = T_MAX_8009;
+    }
+
+    std::vector<Pending> storage;
+    storage.reserve(1024);
+    pending_ = decltype(pending_)(std::greater<Pending>(), std::move(storage));
+}
+
+MotorBusEmulator::~MotorBusEmulator()
+{
+    Stop();
+}
+
+void MotorBusEmulator::Start(LoopbackCanTransport &bus)
+{
+    Stop();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    bus_ = &bus;
+    running_ = true;
+    thread_ = std::thread(&MotorBusEmulator::DeliveryThread, this);
+}
+
+void MotorBusEmulator::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!pending_.empty())
+        pending_.pop();
+}
+
+void MotorBusEmulator::OnFrame(const CanFrame &tx)
+{
+    const int64_t now_ns = MonotonicNowNs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++rx_frames_;
+
+    if (tx.channel < 1 || tx.channel > kNumChannels || tx.can_id == 0 || tx.can_id >= (uint32_t)kNumIds || tx.dlc < 8) {
+        ++unknown_frames_;
+        return;
+    }
+
+    Joint &joint = joints_[tx.channel][tx.can_id];
+    Integrate(joint, now_ns);
+
+    const uint8_t *d = tx.data;
+    if (IsSpecialCommand(d)) {
+        switch (d[7]) {
+        case DM_CMD_ENABLE:  joint.enabled = true; break;
+        case DM_CMD_DISABLE: joint.enabled = false; break;
+        case DM_CMD_ZERO:    joint.q = 0.0; break;
+        default:
+            ++unknown_frames_;
+            return;
+        }
+    } else {
+        joint.p_des = ToFloat((d[0] << 8) | d[1], P_MIN, P_MAX, 16);
+        joint.v_des = ToFloat((d[2] << 4) | (d[3] >> 4), V_MIN, V_MAX, 12);
+        joint.kp    = ToFloat(((d[3] & 0x0F) << 8) | d[4], KP_MIN, KP_MAX, 12);
+        joint.kd    = ToFloat((d[5] << 4) | (d[6] >> 4), KD_MIN, KD_MAX, 12);
+        joint.t_ff  = ToFloat(((d[6] & 0x0F) << 8) | d[7], joint.tau_min, joint.tau_max, 12);
+    }
+
+    // 指令帧本身占用总线
+    int64_t &bus_free_ns = bus_free_ns_[tx.channel];
+    bus_free_ns = std::max(bus_free_ns, now_ns) + frame_time_ns_;
+
+    if (config_.loss_rate > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < config_.loss_rate) {
+        ++dropped_frames_;
+        return;
+    }
+
+    int64_t delay_ns = (int64_t)std::max(config_.latency_us, 0) * 1000;
+    if (config_.jitter_us > 0)
+        delay_ns += std::uniform_int_distribution<int64_t>(0, (int64_t)config_.jitter_us * 1000)(rng_);
+
+    // 反馈帧在总线空闲后才能开始发送
+    const int64_t due_ns = std::max(now_ns + delay_ns, bus_free_ns) + frame_time_ns_;
+    bus_free_ns = due_ns;
+
+    Pending reply;
+    reply.due_ns = due_ns;
+    reply.frame.channel = tx.channel;
+    reply.frame.can_id = DM_FEEDBACK_ID_BASE | tx.can_id;
+    reply.frame.dlc = 8;
+    reply.frame.timestamp_ns = 0;
+    EncodeFeedback(joint, (uint8_t)tx.can_id, reply.frame.data);
+
+    pending_.push(reply);
+    cv_.notify_one();
+}
+
+/// @brief 单关节模型: J*ddq = tau - b*dq, tau 为 MIT 控制律输出, 半隐式欧拉积分
+void MotorBusEmulator::Integrate(Joint &joint, int64_t now_ns)
+{
+    if (joint.last_ns == 0) {
+        joint.last_ns = now_ns;
+        return;
+    }
+
+    int64_t remaining_ns = std::min(now_ns - joint.last_ns, kMaxIntegrateNs);
+    joint.last_ns = now_ns;
+
+    while (remaining_ns > 0) {
+        const int64_t step_ns = std::min(remaining_ns, kMaxStepNs);
+        const double dt = step_ns * 1e-9;
+        remaining_ns -= step_ns;
+
+        double tau = 0.0;
+        if (joint.enabled) {
+            tau = joint.kp * (joint.p_des - joint.q) + joint.kd * (joint.v_des - joint.dq) + joint.t_ff;
+            tau = std::min<double>(std::max<double>(tau, joint.tau_min), joint.tau_max);
+        }
+        joint.tau = tau;
+
+        const double ddq = (tau - config_.damping * joint.dq) / config_.inertia;
+        joint.dq = std::min<double>(std::max<double>(joint.dq + ddq * dt, V_MIN), V_MAX);
+        joint.q = std::min<double>(std::max<double>(joint.q + joint.dq * dt, P_MIN), P_MAX);
+    }
+}
+
+/// @brief 按 CAN_RX_Decode 期望的格式编码反馈帧
+void MotorBusEmulator::EncodeFeedback(const Joint &joint, uint8_t id, uint8_t *data) const
+{
+    const int p = ToUint(joint.q, P_MIN, P_MAX, 16);
+    const int v = ToUint(joint.dq, V_MIN, V_MAX, 12);
+    const int t = ToUint(joint.tau, joint.tau_min, joint.tau_max, 12);
+    const uint8_t err = joint.enabled ? 1 : 0;
+
+    data[0] = (uint8_t)((err << 4) | (id & 0x0F));
+    data[1] = (uint8_t)(p >> 8);
+    data[2] = (uint8_t)(p & 0xFF);
+    data[3] = (uint8_t)(v >> 4);
+    data[4] = (uint8_t)(((v & 0x0F) << 4) | (t >> 8));
+    data[5] = (uint8_t)(t & 0xFF);
+    data[6] = 30; // MOS 温度
+    data[7] = 30; // 线圈温度
+}
+
+void MotorBusEmulator::DeliveryThread()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        if (pending_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+
+        const int64_t wait_ns = pending_.top().due_ns - MonotonicNowNs();
+        if (wait_ns > 0) {
+            cv_.wait_for(lock, std::chrono::nanoseconds(wait_ns));
+            continue;
+        }
+
+        const CanFrame frame = pending_.top().frame;
+        pending_.pop();
+
+        lock.unlock();
+        bus_->Inject(frame);
+        tx_frames_.fetch_add(1, std::memory_order_relaxed);
+        lock.lock();
+    }
+}
+
+MotorBusEmulator::Stats MotorBusEmulator::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {rx_frames_, tx_frames_.load(std::memory_order_relaxed), dropped_frames_, unknown_frames_};
+}
+
+float MotorBusEmulator::GetPosition(int channel, int id) const
+{
+    if (channel < 1 || channel > kNumChannels || id < 1 || id >= kNumIds)
+        return 0.0f;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (float)joints_[channel][id].q;
+}
+
+/*********************************       *** EmulatedCanTransport ***      ***********************************************/
+
+EmulatedCanTransport::EmulatedCanTransport(const CanEmulatorConfig &config) : emulator_(config) {}
+
+bool EmulatedCanTransport::Open()
+{
+    emulator_.Start(*this);
+    SetResponder([this](const CanFrame &tx, LoopbackCanTransport &) { emulator_.OnFrame(tx); });
+    std::cout << "[INFO] CAN emulator started" << std::endl;
+    return true;
+}
+
+void EmulatedCanTransport::Close()
+{
+    SetResponder(nullptr);
+    emulator_.Stop();
+}
@@ -0,0 +1,317 @@
+// Copyright (c) 2023–2025 TANGAIR
+// SPDX-License-Identifier: Apache-2.0
+
+// 1 kHz 控制路径上各热点函数的微基准, 输出 ns/op 与 allocs/op
+// 用法: ./reddog_bench [--benchmark_filter=...]
+
+#include "Tangair_usb2can_motor_imu.h"
+
+#include <benchmark/benchmark.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+
+#ifndef REDDOG_CONFIG_PATH
+#define REDDOG_CONFIG_PATH "config/config.yaml"
+#endif
+
+// ========== 分配计数 ==========
+static std::atomic<uint64_t> g_alloc_count{0};
+
+// noinline: 避免 GCC 在调用点展开成 malloc/free 后误报 -Wmismatched-new-delete
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+// 在基准循环前后调用, 把循环内的分配次数折算为 allocs/op
+class AllocCounter
+{
+public:
+    explicit AllocCounter(benchmark::State &state)
+        : state_(state), start_(g_alloc_count.load(std::memory_order_relaxed)) {}
+
+    ~AllocCounter()
+    {
+        const double allocs = (double)(g_alloc_count.load(std::memory_order_relaxed) - start_);
+        state_.counters["allocs/op"] = benchmark::Counter(allocs, benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State &state_;
+    uint64_t start_;
+};
+
+// ========== 被测对象 ==========
+// 读取仓库中的 config.yaml, 把CAN传输层换成回环, 不触碰硬件
+static Tangair_usb2can &Robot()
+{
+    static std::unique_ptr<Tangair_usb2can> robot = [] {
+        YAML::Node config = YAML::LoadFile(REDDOG_CONFIG_PATH);
+        config["can_transport"]["type"] = "loopback";
+        config["flight_recorder"]["enabled"] = false;
+        config["latency_stats"]["shared_memory"] = false;
+
+        const std::string path = "/tmp/reddog_bench_config.yaml";
+        std::ofstream(path) << config;
+        return std::unique_ptr<Tangair_usb2can>(new Tangair_usb2can(path));
+    }();
+    return *robot;
+}
+
+static std::array<double, 12> StandPose()
+{
+    return {0.0, 0.8, -1.6, 0.0, 0.8, -1.6, 0.0, 0.8, -1.6, 0.0, 0.8, -1.6};
+}
+
+// ========== 定点换算 ==========
+static void BM_FloatToUint(benchmark::State &state)
+{
+    float x = 1.234f;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x);
+        benchmark::DoNotOptimize(float_to_uint(x, P_MIN, P_MAX, 16));
+    }
+}
+BENCHMARK(BM_FloatToUint);
+
+static void BM_UintToFloat(benchmark::State &state)
+{
+    int x = 40000;
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(x);
+        benchmark::DoNotOptimize(uint_to_float(x, P_MIN, P_MAX, 16));
+    }
+}
+BENCHMARK(BM_UintToFloat);
+
+// ========== CAN 编解码 ==========
+// 限幅 + 8字节打包 + 回环发送
+static void BM_CanSendControl(benchmark::State &state)
+{
+    Tangair_usb2can &robot = Robot();
+    const JointDescriptor &joint = robot.Joint(8); // RRC
+    Motor_CAN_Send_Struct motor = robot.MotorSend(8);
+    motor.position = 1.0f;
+    motor.speed = 0.5f;
+    motor.kp = 30.0f;
+    motor.kd = 0.5f;
+    motor.torque = 2.0f;
+
+    // 回环队列满后 Inject 直接返回, 每半个队列暂停计时取空一次
+    CanTransport &transport = robot.GetCanTransport(joint.adapter);
+    CanFrame drained[64];
+    while (transport.Receive(drained, 64, 0) > 0) {
+    }
+    size_t pending = 0;
+
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        robot.CAN_Send_Control(joint.adapter, joint.bus, &motor);
+        benchmark::ClobberMemory();
+        if (++pending < LoopbackCanTransport::kQueueSize / 2)
+            continue;
+        state.PauseTiming();
+        while (transport.Receive(drained, 64, 0) > 0) {
+        }
+        pending = 0;
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_CanSendControl);
+
+// 单帧反馈解码
+static void BM_CanRxDecode(benchmark::State &state)
+{
+    Tangair_usb2can &robot = Robot();
+    const uint8_t data[8] = {0x13, 0x84, 0x21, 0x80, 0x07, 0xFF, 0x1E, 0x1E};
+
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        robot.CAN_RX_Decode(2, 0x13, data);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_CanRxDecode);
+
+// 一次读取到的整机12帧反馈整批解码
+static void BM_CanRxDecodeBatch(benchmark::State &state)
+{
+    Tangair_usb2can &robot = Robot();
+    CanFrame frames[NUM_MOTOR];
+    for (int j = 0; j < NUM_MOTOR; ++j) {
+        const JointDescriptor &joint = robot.Joint(j);
+        const uint8_t data[8] = {joint.can_id, 0x84, 0x21, 0x80, 0x07, 0xFF, 0x1E, 0x1E};
+        frames[j].channel = joint.bus;
+        frames[j].can_id = DM_FEEDBACK_ID_BASE | joint.can_id;
+        frames[j].dlc = 8;
+        std::memcpy(frames[j].data, data, 8);
+        frames[j].timestamp_ns = 0;
+        frames[j].hw_timestamp_ns = 0;
+    }
+
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        robot.CAN_RX_DecodeBatch(frames, NUM_MOTOR, 0);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_MOTOR);
+}
+BENCHMARK(BM_CanRxDecodeBatch);
+
+// 整机12帧批量编码 / 解码
+static void BM_MitEncodeBatch(benchmark::State &state)
+{
+    MitBatchCodec codec;
+    MitCommandBatch cmd;
+    for (int i = 0; i < kMitBatchSize; ++i) {
+        cmd.position[i] = 0.1f * i;
+        cmd.velocity[i] = 0.5f;
+        cmd.kp[i] = 30.0f;
+        cmd.kd[i] = 0.5f;
+        cmd.torque[i] = 2.0f;
+    }
+    alignas(16) uint8_t payloads[kMitBatchSize][8];
+
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cmd);
+        codec.Encode(cmd, payloads);
+        benchmark::DoNotOptimize(payloads);
+    }
+}
+BENCHMARK(BM_MitEncodeBatch);
+
+static void BM_MitDecodeBatch(benchmark::State &state)
+{
+    MitBatchCodec codec;
+    alignas(16) uint8_t payloads[kMitBatchSize][8];
+    for (int i = 0; i < kMitBatchSize; ++i) {
+        const uint8_t data[8] = {0x13, 0x84, 0x21, 0x80, 0x07, 0xFF, 0x1E, 0x1E};
+        std::copy(data, data + 8, payloads[i]);
+    }
+    MitFeedbackBatch fb;
+
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(payloads);
+        codec.Decode(payloads, fb);
+        benchmark::DoNotOptimize(fb);
+    }
+}
+BENCHMARK(BM_MitDecodeBatch);
+
+// ========== 关节顺序映射 ==========
+static void BM_MujocoToReal(benchmark::State &state)
+{
+    std::array<double, 12> dof_pos = StandPose();
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dof_pos);
+        benchmark::DoNotOptimize(mujoco_ang2real_ang(dof_pos));
+    }
+}
+BENCHMARK(BM_MujocoToReal);
+
+static void BM_RealToMujoco(benchmark::State &state)
+{
+    Matrix3x4d real = mujoco_ang2real_ang(StandPose());
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(real);
+        benchmark::DoNotOptimize(real_ang2mujoco_ang(real));
+    }
+}
+BENCHMARK(BM_RealToMujoco);
+
+// ========== 指令校验 ==========
+static void BM_CheckPositionAndGainValidity(benchmark::State &state)
+{
+    Tangair_usb2can &robot = Robot();
+    const Matrix3x4d positions = Matrix3x4d::Zero();
+    const Matrix3x4d kp = Matrix3x4d::Constant(20.0);
+    const Matrix3x4d kd = Matrix3x4d::Constant(0.5);
+
+    AllocCounter allocs(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(robot.CheckPositionAndGainValidity(positions, kp, kd));
+}
+BENCHMARK(BM_CheckPositionAndGainValidity);
+
+// ========== 状态汇总 ==========
+// 原 GetMotorFloatVector 的职责已并入 UpdateMotorState
+static void BM_UpdateMotorState(benchmark::State &state)
+{
+    Tangair_usb2can &robot = Robot();
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        robot.UpdateMotorState();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_UpdateMotorState);
+
+static void BM_GetMotorState(benchmark::State &state)
+{
+    Tangair_usb2can &robot = Robot();
+    AllocCounter allocs(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(robot.GetMotorState());
+}
+BENCHMARK(BM_GetMotorState);
+
+// ========== DDS 指令回调 ==========
+static void BM_LowCmdMessageHandler(benchmark::State &state)
+{
+    Tangair_usb2can &robot = Robot();
+    unitree_go::msg::dds_::LowCmd_ cmd;
+    const std::array<double, 12> pose = StandPose();
+    for (int i = 0; i < 12; ++i) {
+        cmd.motor_cmd()[i].q((float)pose[i]);
+        cmd.motor_cmd()[i].kp(20.0f);
+        cmd.motor_cmd()[i].kd(0.5f);
+    }
+
+    AllocCounter allocs(state);
+    for (auto _ : state) {
+        robot.LowCmdMessageHandler(&cmd);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_LowCmdMessageHandler);
+
+// ========== 飞行记录器 ==========
+// 单帧写入, 目标 < 1us
+static void BM_FlightRecorderAppend(benchmark::State &state)
+{
+    FlightRecorderConfig config;
+    config.path = "/tmp/reddog_bench_flight.bin";
+    config.tx_records = 65536;
+    config.rx_records = config.lowcmd_records = config.imu_records = 1;
+    FlightRecorder recorder;
+    if (!recorder.Open(config)) {
+        state.SkipWithError("failed to open flight recorder");
+        return;
+    }
+    const uint8_t data[8] = {0x7F, 0xFF, 0x80, 0x01, 0x33, 0x08, 0x07, 0xFF};
+
+    AllocCounter allocs(state);
+    for (auto _ : state)
+        recorder.Append(kFlightStreamTx, kFlightRecordTxFrame, 1, 0x01, data, 8, MonotonicNowNs());
+}
+BENCHMARK(BM_FlightRecorderAppend);
+
+BENCHMARK_MAIN();
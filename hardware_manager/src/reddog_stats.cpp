@@ -0,0 +1,58 @@
+// Copyright (c) 2023–2025 TANGAIR
+// SPDX-License-Identifier: Apache-2.0
+
+// 在线读取 can_node_motor_imu 的各环节延迟统计 (共享内存), 不影响实时线程
+// 用法: ./reddog_stats [--name /reddog_latency] [--watch 秒]
+
+#include "stage_latency.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+    std::string name = LatencyStatsConfig().shm_name;
+    double watch_seconds = 0.0;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--name") == 0)
+            name = argv[++i];
+        else if (std::strcmp(argv[i], "--watch") == 0)
+            watch_seconds = std::atof(argv[++i]);
+    }
+
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::fprintf(stderr, "[ERROR] cannot open shared memory %s (is can_node_motor_imu running?)\n", name.c_str());
+        return 1;
+    }
+    void *map = mmap(nullptr, sizeof(LatencyStatsBlock), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::fprintf(stderr, "[ERROR] cannot map %s\n", name.c_str());
+        return 1;
+    }
+
+    const LatencyStatsBlock &block = *(const LatencyStatsBlock *)map;
+    if (std::memcmp(block.magic, kLatencyStatsMagic, sizeof(kLatencyStatsMagic)) != 0 ||
+        block.num_stages != kNumLatencyStages || block.histogram_size != sizeof(LatencyHistogram)) {
+        std::fprintf(stderr, "[ERROR] %s has an unexpected layout\n", name.c_str());
+        return 1;
+    }
+
+    do {
+        if (watch_seconds > 0.0)
+            std::cout << "\033[2J\033[H";
+        StageLatencyStats::Print(block, std::cout);
+        std::cout.flush();
+        if (watch_seconds > 0.0)
+            usleep((useconds_t)(watch_seconds * 1e6));
+    } while (watch_seconds > 0.0);
+
+    munmap(map, sizeof(LatencyStatsBlock));
+    return 0;
+}
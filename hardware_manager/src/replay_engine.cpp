@@ -0,0 +1,270 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#include "replay_engine.h"
+#include "rt_time.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <time.h>
+
+namespace {
+
+// 按 CLOCK_MONOTONIC 绝对时间睡眠到 target_ns
+void SleepUntil(int64_t target_ns)
+{
+    struct timespec ts;
+    ts.tv_sec = target_ns / 1000000000LL;
+    ts.tv_nsec = target_ns % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
+
+// 取出回环传输层中本周期发出的帧
+int DrainTx(CanTransport &transport, CanFrame *frames, int max_frames)
+{
+    int n = 0;
+    while (n < max_frames) {
+        const int got = transport.Receive(frames + n, max_frames - n, 0);
+        if (got <= 0)
+            break;
+        n += got;
+    }
+    // 多出的帧丢弃, 避免累积到下一周期
+    CanFrame discard[8];
+    while (transport.Receive(discard, 8, 0) > 0) {
+    }
+    return n;
+}
+
+void PrintFrame(const char *tag, uint8_t channel, uint32_t id, const uint8_t *data)
+{
+    std::printf("    %s ch%u id=0x%03X data=", tag, channel, id);
+    for (int i = 0; i < 8; ++i)
+        std::printf("%02X", data[i]);
+    std::printf("\n");
+}
+
+} // namespace
+
+ReplayEngine::ReplayEngine(Tangair_usb2can &robot) : robot_(robot) {}
+
+bool ReplayEngine::IsCommandFrame(const FlightEvent &e)
+{
+    for (int i = 0; i < 7; ++i)
+        if (e.payload[i] != 0xFF)
+            return false;
+    return true;
+}
+
+/// @brief 调度表中第1个适配器的首个槽位, 其帧标志记录中一个周期的开始
+const CAN_TX_Slot_Struct &ReplayEngine::FirstSlot() const
+{
+    for (int i = 0; i < kMitBatchSize; ++i)
+        if (robot_.GetTxSlot(i).adapter == 0)
+            return robot_.GetTxSlot(i);
+    return robot_.GetTxSlot(0);
+}
+
+bool ReplayEngine::Load(const std::string &path)
+{
+    if (!LoadFlightTrace(path, trace_))
+        return false;
+
+    tx_frames_.clear();
+    for (const FlightEvent &e : trace_.events)
+        if (e.stream == kFlightStreamTx && !IsCommandFrame(e) && FlightAdapter(e.channel) == 0)
+            tx_frames_.push_back(&e);
+
+    std::cout << "[INFO] Replay trace " << path << ": " << trace_.events.size() << " records, "
+              << tx_frames_.size() << " control frames" << std::endl;
+    return !trace_.events.empty();
+}
+
+void ReplayEngine::ReplayLowCmd(const FlightEvent &e)
+{
+    float v[12];
+    std::memcpy(v, e.payload, sizeof(v));
+
+    auto &motor_cmds = low_cmd_.motor_cmd();
+    for (int i = 0; i < 12; ++i) {
+        switch (e.type) {
+        case kFlightRecordLowCmdQ:  motor_cmds[i].q(v[i]); break;
+        case kFlightRecordLowCmdKp: motor_cmds[i].kp(v[i]); break;
+        case kFlightRecordLowCmdKd: motor_cmds[i].kd(v[i]); break;
+        default: return;
+        }
+    }
+
+    // q -> kp -> kd 依次写入, 三条到齐后作为一条消息交给回调
+    low_cmd_parts_ |= 1u << (e.type - kFlightRecordLowCmdQ);
+    if (e.type == kFlightRecordLowCmdKd && low_cmd_parts_ == 0x7) {
+        robot_.LowCmdMessageHandler(&low_cmd_);
+        low_cmd_seen_ = true;
+    }
+    if (e.type == kFlightRecordLowCmdKd)
+        low_cmd_parts_ = 0;
+}
+
+void ReplayEngine::ReplayImu(const FlightEvent &e)
+{
+    ImuState imu{};
+    std::memcpy(imu.quat, e.payload, 4 * sizeof(float));
+    std::memcpy(imu.gyr, e.payload + 4 * sizeof(float), 3 * sizeof(float));
+    std::memcpy(imu.acc, e.payload + 7 * sizeof(float), 3 * sizeof(float));
+    std::memcpy(&imu.packet_counter, e.payload + 10 * sizeof(float), sizeof(uint32_t));
+    imu.timestamp_ns = MonotonicNowNs();
+    robot_.StoreImuSample(imu);
+}
+
+/// @brief 记录中一个TX周期的起点: 生成快照、执行一拍, 再与记录的本周期各帧比较
+void ReplayEngine::RunCycle(size_t tx_index, const ReplayOptions &options, ReplayReport &report)
+{
+    const CAN_TX_Slot_Struct &first_slot = FirstSlot();
+    const uint64_t cycle = cycle_index_++;
+
+    const int64_t start_ns = MonotonicNowNs();
+    robot_.UpdateMotorState();
+    robot_.ControlStep(cycle % (uint64_t)std::max(options.publish_divider, 1) == 0);
+    cycle_exec_.Record(MonotonicNowNs() - start_ns);
+    ++report.cycles;
+    robot_.ReportLimitViolations();
+
+    CanFrame out[kMitBatchSize];
+    const int n = DrainTx(robot_.GetCanTransport(robot_.USB2CAN0_), out, kMitBatchSize);
+    CanFrame discard[kMitBatchSize];
+    for (int a = 1; a < robot_.NumAdapters(); ++a)
+        DrainTx(robot_.GetCanTransport(a), discard, kMitBatchSize);
+
+    // 第一条 LowCmd 之前的指令状态未知, 只执行不比较
+    if (!options.compare_tx || !low_cmd_seen_)
+        return;
+
+    // 本周期的记录帧: 从起点到下一个起点, 最多12帧
+    int m = 0;
+    while (m < kMitBatchSize && tx_index + m < tx_frames_.size()) {
+        const FlightEvent &e = *tx_frames_[tx_index + m];
+        if (m > 0 && e.channel == first_slot.channel && e.id == first_slot.motor->id)
+            break;
+        ++m;
+    }
+
+    bool mismatch = m != n;
+    for (int i = 0; i < std::min(m, n); ++i) {
+        const FlightEvent &expect = *tx_frames_[tx_index + i];
+        const CanFrame &actual = out[i];
+        ++report.tx_compared;
+        if (expect.channel == actual.channel && expect.id == actual.can_id &&
+            std::memcmp(expect.payload, actual.data, 8) == 0)
+            continue;
+
+        ++report.tx_mismatches;
+        if (report.first_mismatch_cycle < 0) {
+            std::printf("[REPLAY] first TX mismatch at cycle %llu, slot %d:\n", (unsigned long long)cycle, i);
+            PrintFrame("expected", expect.channel, expect.id, expect.payload);
+            PrintFrame("actual  ", actual.channel, actual.can_id, actual.data);
+        }
+        mismatch = true;
+    }
+    if (m > n)
+        report.tx_missing += m - n;
+    else
+        report.tx_extra += n - m;
+
+    if (mismatch && report.first_mismatch_cycle < 0)
+        report.first_mismatch_cycle = (int64_t)cycle;
+}
+
+ReplayReport ReplayEngine::Run(const ReplayOptions &options)
+{
+    ReplayReport report;
+    if (trace_.events.empty())
+        return report;
+
+    const CAN_TX_Slot_Struct &first_slot = FirstSlot();
+    CanTransport &transport = robot_.GetCanTransport(robot_.USB2CAN0_);
+
+    robot_.SetTxPacing(options.realtime);
+    CanFrame discard[kMitBatchSize];
+    DrainTx(transport, discard, kMitBatchSize);
+
+    lateness_.Reset();
+    cycle_exec_.Reset();
+    cycle_index_ = 0;
+    low_cmd_parts_ = 0;
+    low_cmd_seen_ = false;
+
+    const int64_t trace_start_ns = trace_.events.front().t_ns;
+    const int64_t wall_start_ns = MonotonicNowNs();
+    size_t tx_index = 0; // 记录开头不完整的周期没有起点帧, 自然跳过
+
+    for (const FlightEvent &e : trace_.events) {
+        if (options.realtime) {
+            const int64_t target_ns = wall_start_ns + (e.t_ns - trace_start_ns);
+            if (MonotonicNowNs() < target_ns)
+                SleepUntil(target_ns);
+            lateness_.Record(MonotonicNowNs() - target_ns);
+        }
+        ++report.events;
+
+        switch (e.stream) {
+        case kFlightStreamRx:
+            robot_.CAN_RX_Decode(FlightBusChannel(e.channel), e.id, e.payload, 0, FlightAdapter(e.channel));
+            ++report.rx_frames;
+            break;
+        case kFlightStreamImu:
+            ReplayImu(e);
+            ++report.imu_samples;
+            break;
+        case kFlightStreamLowCmd:
+            ReplayLowCmd(e);
+            if (e.type == kFlightRecordLowCmdKd)
+                ++report.lowcmds;
+            break;
+        case kFlightStreamTx:
+            if (IsCommandFrame(e) || FlightAdapter(e.channel) != 0)
+                break;
+            // 调度表首个槽位的帧即新周期的起点, 本周期其余帧在 RunCycle 中比较
+            if (e.channel == first_slot.channel && e.id == first_slot.motor->id)
+                RunCycle(tx_index, options, report);
+            ++tx_index;
+            break;
+        default:
+            break;
+        }
+    }
+
+    report.wall_ns = MonotonicNowNs() - wall_start_ns;
+    report.trace_ns = trace_.events.back().t_ns - trace_start_ns;
+    report.lateness_p99_ns = lateness_.Percentile(0.99);
+    report.lateness_max_ns = lateness_.Max();
+    report.cycle_p50_ns = cycle_exec_.Percentile(0.50);
+    report.cycle_p99_ns = cycle_exec_.Percentile(0.99);
+    report.cycle_max_ns = cycle_exec_.Max();
+
+    robot_.SetTxPacing(true);
+    return report;
+}
+
+void ReplayEngine::PrintReport(const ReplayReport &r, const ReplayOptions &options)
+{
+    const double wall_s = std::max(r.wall_ns, (int64_t)1) * 1e-9;
+
+    std::printf("[REPLAY] mode=%s trace=%.3fs wall=%.3fs (x%.1f)\n", options.realtime ? "realtime" : "fast",
+                r.trace_ns * 1e-9, wall_s, r.trace_ns * 1e-9 / wall_s);
+    std::printf("[REPLAY] events=%llu (%.0f/s) rx=%llu imu=%llu lowcmd=%llu cycles=%llu (%.0f/s)\n",
+                (unsigned long long)r.events, r.events / wall_s, (unsigned long long)r.rx_frames,
+                (unsigned long long)r.imu_samples, (unsigned long long)r.lowcmds,
+                (unsigned long long)r.cycles, r.cycles / wall_s);
+    std::printf("[REPLAY] cycle(us) p50/p99/max = %.1f/%.1f/%.1f\n",
+                r.cycle_p50_ns / 1e3, r.cycle_p99_ns / 1e3, r.cycle_max_ns / 1e3);
+    if (options.realtime)
+        std::printf("[REPLAY] lateness(us) p99/max = %.1f/%.1f\n", r.lateness_p99_ns / 1e3, r.lateness_max_ns / 1e3);
+    if (options.compare_tx)
+        std::printf("[REPLAY] TX compared=%llu mismatched=%llu missing=%llu extra=%llu -> %s\n",
+                    (unsigned long long)r.tx_compared, (unsigned long long)r.tx_mismatches,
+                    (unsigned long long)r.tx_missing, (unsigned long long)r.tx_extra,
+                    r.first_mismatch_cycle < 0 ? "MATCH" : "MISMATCH");
+}
@@ -0,0 +1,101 @@
+// # Copyright (c) 2023-2025 TANGAIR
+// # SPDX-License-Identifier: Apache-2.0
+#include "stage_latency.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <new>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+const char *LatencyStageName(int stage)
+{
+    static const char *const kNames[kNumLatencyStages] = {
+        "dds_handler", "cmd_wait", "validate", "tx_encode", "tx_frame",
+        "cmd_to_tx", "rx_decode", "rx_to_publish", "imu_to_publish", "publish",
+    };
+    return stage >= 0 && stage < kNumLatencyStages ? kNames[stage] : "unknown";
+}
+
+StageLatencyStats::StageLatencyStats() : local_(new LatencyStatsBlock)
+{
+    InitBlock(local_.get());
+    block_ = local_.get();
+}
+
+StageLatencyStats::~StageLatencyStats()
+{
+    // 共享内存段保留, 进程退出后仍可读取最后的统计, 下次启动时覆盖
+    if (block_ != local_.get())
+        munmap(block_, shm_size_);
+}
+
+void StageLatencyStats::InitBlock(LatencyStatsBlock *block)
+{
+    std::memcpy(block->magic, kLatencyStatsMagic, sizeof(kLatencyStatsMagic));
+    block->num_stages = kNumLatencyStages;
+    block->histogram_size = sizeof(LatencyHistogram);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    block->start_realtime_ns = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/// @brief 在启动各线程之前调用
+bool StageLatencyStats::OpenShared(const std::string &name)
+{
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "[WARN] shm_open " << name << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    const size_t size = sizeof(LatencyStatsBlock);
+    if (ftruncate(fd, (off_t)size) != 0) {
+        std::cerr << "[WARN] ftruncate " << name << " failed: " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "[WARN] mmap " << name << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    LatencyStatsBlock *block = new (map) LatencyStatsBlock;
+    InitBlock(block);
+    block_ = block;
+    shm_size_ = size;
+
+    std::cout << "[INFO] Latency stats: /dev/shm" << name << std::endl;
+    return true;
+}
+
+void StageLatencyStats::Reset()
+{
+    for (auto &stage : block_->stages)
+        stage.Reset();
+}
+
+void StageLatencyStats::Print(const LatencyStatsBlock &block, std::ostream &os)
+{
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-14s %10s %10s %10s %10s %10s\n",
+                  "stage", "count", "p50(us)", "p99(us)", "p999(us)", "max(us)");
+    os << line;
+
+    for (int i = 0; i < kNumLatencyStages; ++i) {
+        const LatencyHistogram &h = block.stages[i];
+        std::snprintf(line, sizeof(line), "%-14s %10llu %10.1f %10.1f %10.1f %10.1f\n",
+                      LatencyStageName(i), (unsigned long long)h.Count(),
+                      h.Percentile(0.50) / 1e3, h.Percentile(0.99) / 1e3,
+                      h.Percentile(0.999) / 1e3, h.Max() / 1e3);
+        os << line;
+    }
+}
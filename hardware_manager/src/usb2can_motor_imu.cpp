@@ -9,11 +9,16 @@
 #include <stdexcept>
 #include <mutex>
 #include <thread> 
+#include <string_view>
 
 #include "callback_handler.h"
 #include <iomanip>
 #include <string>
 #include <cassert>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
 
 #include <yaml-cpp/yaml.h>
 
@@ -26,24 +31,60 @@ XsControl* control = nullptr;
 XsDevice* device = nullptr;
 XsPortInfo mtPort;
 CallbackHandler callback;
-SensorData sensorData;
 
 /// @brief 构造函数，初始化
 /// @return
-Tangair_usb2can::Tangair_usb2can()
+Tangair_usb2can::Tangair_usb2can(const std::string& config_path, bool replay_mode)
 {
+    if (!config_path.empty())
+        LoadConfigFromYAML(config_path);
+    if (can_topology_config_.adapters.empty())
+        can_topology_config_.adapters.push_back(can_transport_config_);
+    if (replay_mode) {
+        for (CanTransportConfig &adapter : can_topology_config_.adapters)
+            adapter.type = "loopback";
+        flight_recorder_config_.enabled = false;
+    }
+
+    // 打开失败时由传输层打印错误
+    for (const CanTransportConfig &adapter : can_topology_config_.adapters) {
+        can_transports_.push_back(CreateCanTransport(adapter));
+        can_transports_.back()->Open();
+    }
+    USB2CAN0_ = 0;
+
+    rx_complete_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    reply_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    lowstate_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    tx_worker_fd_.assign(can_transports_.size(), -1);
+    adapter_polled_.assign(can_transports_.size(), 0);
+    for (size_t a = 1; a < can_transports_.size(); ++a)
+        tx_worker_fd_[a] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (latency_stats_config_.shared_memory)
+        stage_latency_.OpenShared(latency_stats_config_.shm_name);
+
+    if (flight_recorder_config_.enabled && flight_recorder_.Open(flight_recorder_config_))
+        flight_recorder_.InstallFaultHandlers();
 
-    USB2CAN0_ = openUSBCAN("/dev/ttyRedDog");
-    if (USB2CAN0_ == -1)
-        std::cout << std::endl
-                  << "ttyRedDog open INcorrect!!!" << std::endl;
-    else
-        std::cout << std::endl
-                  << "ttyRedDog opened ,num=" << USB2CAN0_ << std::endl;
+    // 插值段长不短于一个控制周期
+    const int rate_hz = std::min(std::max(realtime_config_.control_loop.rate_hz, kMinControlRateHz), kMaxControlRateHz);
+    command_interpolator_.Configure(interpolation_config_, 1000000000LL / rate_hz);
 
     // 电机ID配置
     USB2CAN_CAN_Bus_Init();
 
+    // 收到反馈前先发布起始姿态
+    MotorStateBlock start_state;
+    start_state.position = {0.0, 1.6, -2.8, -0.0, 1.6, -2.8, -0.0, -1.6, 2.8, 0.0, -1.6, 2.8};
+    start_state.velocity.fill(0.0f);
+    start_state.torque.fill(0.0f);
+    start_state.cycle = 0;
+    start_state.stale_mask = kAllJointsMask;
+    start_state.timestamp_ns = MonotonicNowNs();
+    start_state.sample_ns.fill(0);
+    motor_state_.Store(start_state);
+
     // 启动成功
     std::cout << std::endl
               << "ttyRedDog   NODE INIT__OK   by TANGAIR" << std::endl
@@ -56,9 +97,69 @@ Tangair_usb2can::~Tangair_usb2can()
 {
     std::cout << "End";
     StopAllThreads();
+    StopIoReactor();
 
     // 关闭设备
-    closeUSBCAN(USB2CAN0_);
+    for (auto &transport : can_transports_)
+        transport->Close();
+
+    if (rx_complete_fd_ >= 0)
+        close(rx_complete_fd_);
+    if (reply_fd_ >= 0)
+        close(reply_fd_);
+    if (lowstate_fd_ >= 0)
+        close(lowstate_fd_);
+    for (int fd : tx_worker_fd_)
+        if (fd >= 0)
+            close(fd);
+}
+
+/// @brief 启动时调用: 锁定内存并预取主线程栈, 需在 LoadConfigFromYAML 之后、创建各线程之前
+void Tangair_usb2can::SetupRealtime()
+{
+    if (realtime_config_.lock_memory)
+        LockProcessMemory();
+    PrefaultStack(PrefaultStackBytes());
+}
+
+void Tangair_usb2can::PrintLatencyStats() const
+{
+    stage_latency_.Print(std::cout);
+
+    const CommandValidatorStats v = command_validator_.GetStats();
+    std::cout << "limits (" << (command_validator_.Mode() == LimitViolationMode::kClamp ? "clamp" : "reject")
+              << "): checked " << v.checked << ", rejected " << v.rejected << ", clamped " << v.clamped
+              << " (" << v.clamped_values << " values), reports dropped " << v.reports_dropped << std::endl;
+
+    static const char *const kModeNames[] = {"hold", "linear", "cubic", "min_jerk"};
+    const CommandInterpolatorStats in = command_interpolator_.GetStats();
+    std::cout << "interpolation (" << kModeNames[(int)command_interpolator_.Mode()] << "): commands " << in.commands
+              << " (rejected " << in.rejected << ")"
+              << ", interval " << in.interval_ns / 1000 << " us, samples " << in.samples
+              << ", extrapolated " << in.extrapolated << ", held " << in.held << std::endl;
+
+    if (io_reactor_.IsOpen())
+        std::cout << "io_reactor: wakeups " << io_reactor_.Wakeups() << ", dispatches " << io_reactor_.Dispatches() << std::endl;
+}
+
+void Tangair_usb2can::ResetLatencyStats()
+{
+    stage_latency_.Reset();
+}
+
+void Tangair_usb2can::ReportLimitViolations()
+{
+    command_validator_.DrainReports(std::cerr);
+}
+
+bool Tangair_usb2can::DumpFlightRecorder(int64_t end_ns) const
+{
+    return flight_recorder_.IsOpen() && flight_recorder_.DumpConfigured(end_ns);
+}
+
+size_t Tangair_usb2can::PrefaultStackBytes() const
+{
+    return (size_t)std::max(realtime_config_.prefault_stack_kb, 0) * 1024;
 }
 
 // /*********************************       *** IMU related***      ***********************************************/
@@ -86,11 +187,19 @@ int Tangair_usb2can::IMU_Init()
     
     cout << "Found device @ port: " << mtPort.portName().toStdString() << endl;
 
+    // openPort 会启动 XDA 的 DataPoller / DataParser 线程, 以前后的线程列表差集找出它们
+    std::vector<pid_t> threads_before = ListProcessThreads();
+
     if (!control->openPort(mtPort.portName().toStdString(), mtPort.baudrate())) {
         cerr << "Could not open port. Aborting." << endl;
         return -1;
     }
 
+    for (pid_t tid : ListProcessThreads()) {
+        if (std::find(threads_before.begin(), threads_before.end(), tid) == threads_before.end())
+            SetThreadRealtimeByTid(tid, realtime_config_.xda.cpu, realtime_config_.xda.priority);
+    }
+
     device = control->device(mtPort.deviceId());
     assert(device != nullptr);
     device->addCallbackHandler(&callback);
@@ -138,93 +247,114 @@ int Tangair_usb2can::IMU_Init()
 void Tangair_usb2can::StartIMUThread()
 {   
     imu_running_ = true;
+
+    // 样本由 io_reactor 线程处理, 不再单独启动IMU线程
+    if (realtime_config_.io_reactor.enabled && StartIoReactor()) {
+        StartImuMeasurement();
+        return;
+    }
     sensorThread = std::thread(&Tangair_usb2can::startThreadedMeasurement, this);
 }
 
-void Tangair_usb2can::startThreadedMeasurement()
-{   
+bool Tangair_usb2can::StartImuMeasurement()
+{
     if (!device->gotoMeasurement()) {
         cerr << "Failed to enter measurement mode." << endl;
-        return;
+        return false;
     }
 
     if (!device->startRecording()) {
         cerr << "Failed to start recording." << endl;
-        return;
+        return false;
     }
 
-    // === 加入計時與計數器 ===
-    int packetCount = 0;
-    int64_t lastPrintTime = XsTime::timeStampNow();
+    // imu_work_ 保留各欄位最新值, 每個樣本整體發布一次
+    imu_work_ = imu_state_.Load();
+    return true;
+}
+
+void Tangair_usb2can::startThreadedMeasurement()
+{   
+    ApplyThreadRtConfig("imu", realtime_config_.imu, PrefaultStackBytes());
+
+    if (!StartImuMeasurement())
+        return;
 
     while (imu_running_) // 不再限制時間，只依照 imu_running_ 控制
     {   
-        if (callback.packetAvailable()) 
-        {
-            XsDataPacket packet = callback.getNextPacket();
-            cout << setw(5) << fixed << setprecision(2);
-            if (packet.containsCalibratedData()) {
-                sensorData.acc = packet.calibratedAcceleration();
-                sensorData.gyr = packet.calibratedGyroscopeData();
-                sensorData.mag = packet.calibratedMagneticField();
-            }
+        // 由回調的 eventfd 喚醒, 超時只用於檢查 imu_running_
+        if (!callback.waitForPacket(100))
+            continue;
+        DrainImuPackets();
+    }
 
-            if (packet.containsRateOfTurnHR()) {
-                sensorData.gyr = packet.rateOfTurnHR();
+    cout << "\n[INFO] Measurement thread finished." << endl;
+}
 
-                // cout << " |Gyr X:" << sensorData.gyr[0]
-				// 	<< ", Gyr Y:" << sensorData.gyr[1]
-				// 	<< ", Gyr Z:" << sensorData.gyr[2] << endl;
-            }
+void Tangair_usb2can::DrainImuPackets()
+{
+    // 固定長度緩衝, 解包時不分配記憶體
+    XsDataPacket &packet = imu_packet_;
+    ImuState &imu = imu_work_;
+    XsVector3 vec3;
+    int64_t arrival_ns = 0;
+
+    while (callback.tryGetNextPacket(packet, &arrival_ns)) 
+    {
+        if (packet.containsCalibratedData()) {
+            XsDataPacket_calibratedAcceleration(&packet, &vec3);
+            imu.acc[0] = vec3[0]; imu.acc[1] = vec3[1]; imu.acc[2] = vec3[2];
+            XsDataPacket_calibratedGyroscopeData(&packet, &vec3);
+            imu.gyr[0] = vec3[0]; imu.gyr[1] = vec3[1]; imu.gyr[2] = vec3[2];
+            XsDataPacket_calibratedMagneticField(&packet, &vec3);
+            imu.mag[0] = vec3[0]; imu.mag[1] = vec3[1]; imu.mag[2] = vec3[2];
+        }
 
-            if (packet.containsOrientation())
-            {
-                sensorData.quat = packet.orientationQuaternion();
-                sensorData.euler = packet.orientationEuler();
+        if (packet.containsRateOfTurnHR()) {
+            XsDataPacket_rateOfTurnHR(&packet, &vec3);
+            imu.gyr[0] = vec3[0]; imu.gyr[1] = vec3[1]; imu.gyr[2] = vec3[2];
 
-				// cout << "q0:" << sensorData.quat.w()
-				// 	<< ", q1:" << sensorData.quat.x()
-				// 	<< ", q2:" << sensorData.quat.y()
-				// 	<< ", q3:" << sensorData.quat.z();
+            // cout << " |Gyr X:" << imu.gyr[0]
+            // 	<< ", Gyr Y:" << imu.gyr[1]
+            // 	<< ", Gyr Z:" << imu.gyr[2] << endl;
+        }
 
-				// cout << " |Roll:" << sensorData.euler.roll()
-				// 	<< ", Pitch:" << sensorData.euler.pitch()
-				// 	<< ", Yaw:" << sensorData.euler.yaw();
-            }
+        if (packet.containsOrientation())
+        {
+            XsQuaternion quat = packet.orientationQuaternion();
+            imu.quat[0] = quat.w();
+            imu.quat[1] = quat.x();
+            imu.quat[2] = quat.y();
+            imu.quat[3] = quat.z();
+
+            // cout << "q0:" << imu.quat[0]
+            // 	<< ", q1:" << imu.quat[1]
+            // 	<< ", q2:" << imu.quat[2]
+            // 	<< ", q3:" << imu.quat[3];
+        }
 
-            if (packet.containsLatitudeLongitude())
-            {
-                sensorData.latlon = packet.latitudeLongitude();
-                // cout << " |Lat:" << sensorData.latlon[0]
-                //      << ", Lon:" << sensorData.latlon[1];
-            }
+        if (packet.containsPacketCounter())
+            imu.packet_counter = packet.packetCounter();
 
-            if (packet.containsAltitude())
-                sensorData.altitude = packet.altitude();
-                // cout << " |Alt:" << sensorData.altitude;
+        imu.timestamp_ns = arrival_ns;
+        StoreImuSample(imu);
+    }
+}
 
-            if (packet.containsVelocity())
-            {
-                sensorData.velocity = packet.velocity(XDI_CoordSysEnu);
-                // cout << " |E:" << sensorData.velocity[0]
-                //      << ", N:" << sensorData.velocity[1]
-                //      << ", U:" << sensorData.velocity[2];
-            }
-            
-            packetCount++;
-            int64_t now = XsTime::timeStampNow();
-            if (now - lastPrintTime >= 1000) {  // 每秒顯示一次
-                // cout << "\r[INFO] IMU packet rate: " << packetCount << " Hz" << flush;
-                packetCount = 0;
-                lastPrintTime = now;
-            }
-            cout << flush;
-        }
+ImuState Tangair_usb2can::GetImuState() const
+{
+    return imu_state_.Load();
+}
 
-        XsTime::msleep(1);  // 避免 CPU 過度負載
-    }
+void Tangair_usb2can::StoreImuSample(const ImuState &imu)
+{
+    imu_state_.Store(imu);
 
-    cout << "\n[INFO] Measurement thread finished." << endl;
+    // quat[4], gyr[3], acc[3], packet_counter
+    uint8_t record[kFlightPayloadSize];
+    std::memcpy(record, imu.quat, 10 * sizeof(float));
+    std::memcpy(record + 10 * sizeof(float), &imu.packet_counter, sizeof(uint32_t));
+    flight_recorder_.Append(kFlightStreamImu, kFlightRecordImu, 0, 0, record, 10 * sizeof(float) + sizeof(uint32_t), imu.timestamp_ns);
 }
 
 void Tangair_usb2can::IMU_Shutdown()
@@ -242,7 +372,7 @@ void Tangair_usb2can::IMU_Shutdown()
 
 /*********************************       *** DDS related***      ***********************************************/
 
-void Tangair_usb2can::DDS_Init()
+void Tangair_usb2can::DDS_Init(bool lowcmd_input)
 {   
     // /*create publisher*/
     lowstate_publisher.reset(new ChannelPublisher<unitree_go::msg::dds_::LowState_>(TOPIC_LOWSTATE));
@@ -255,17 +385,22 @@ void Tangair_usb2can::DDS_Init()
         std::cout << "[INFO] lowstate_publisher 建立成功，準備開始傳送資料。" << std::endl;
     }
 
+    if (!lowcmd_input)
+        return;
+
     /*create subscriber*/
     lowcmd_subscriber.reset(new ChannelSubscriber<unitree_go::msg::dds_::LowCmd_>(TOPIC_LOWCMD));
     lowcmd_subscriber->InitChannel(std::bind(&Tangair_usb2can::LowCmdMessageHandler, this, std::placeholders::_1), 1);
 
     /*loop publishing thread*/
-    lowStatePuberThreadPtr = CreateRecurrentThreadEx("lowstate", UT_CPU_ID_NONE, 2000, &Tangair_usb2can::PublishLowState, this);
+    lowStatePuberThreadPtr = CreateRecurrentThreadEx("lowstate",
+        realtime_config_.lowstate.cpu >= 0 ? realtime_config_.lowstate.cpu : UT_CPU_ID_NONE, 2000, &Tangair_usb2can::PublishLowStateIdle, this);
     // std::cout << "[DEBUG] "<< std::endl;
 }
 
 void Tangair_usb2can::LowCmdMessageHandler(const void *msg)
 {   
+    const int64_t arrival_ns = MonotonicNowNs();
     const unitree_go::msg::dds_::LowCmd_ *cmd = static_cast<const unitree_go::msg::dds_::LowCmd_ *>(msg);
     if (!cmd) {
         std::cerr << "[ERROR] Received null pointer\n";
@@ -278,9 +413,23 @@ void Tangair_usb2can::LowCmdMessageHandler(const void *msg)
         return;
     }
 
-    dof_pos.clear();
-    Matrix3x4d kp_temp = Matrix3x4d::Zero();
-    Matrix3x4d kd_temp = Matrix3x4d::Zero();
+    std::array<double, 12> dof_pos;
+    std::array<double, 12> dof_vel;
+    LowCmdBlock block;
+    Eigen::Map<Matrix3x4d> kp_temp(block.kp.data());
+    Eigen::Map<Matrix3x4d> kd_temp(block.kd.data());
+
+    if (flight_recorder_.IsOpen()) {
+        float q[12], kp[12], kd[12];
+        for (int i = 0; i < 12; ++i) {
+            q[i] = motor_cmds[i].q();
+            kp[i] = motor_cmds[i].kp();
+            kd[i] = motor_cmds[i].kd();
+        }
+        flight_recorder_.Append(kFlightStreamLowCmd, kFlightRecordLowCmdQ, 0, 0, q, sizeof(q), arrival_ns);
+        flight_recorder_.Append(kFlightStreamLowCmd, kFlightRecordLowCmdKp, 0, 0, kp, sizeof(kp), arrival_ns);
+        flight_recorder_.Append(kFlightStreamLowCmd, kFlightRecordLowCmdKd, 0, 0, kd, sizeof(kd), arrival_ns);
+    }
 
     for (int i = 0; i < 12; ++i) {
         int leg = i / 4;
@@ -293,29 +442,71 @@ void Tangair_usb2can::LowCmdMessageHandler(const void *msg)
 
         // std::cout << "[DEBUG] motor[" << i << "] q=" << q << " kp=" << kp << " kd=" << kd << std::endl;
 
-        dof_pos.push_back(q);
+        dof_pos[i] = q;
+        dof_vel[i] = m.dq();
         kp_temp(leg, joint) = kp;
         kd_temp(leg, joint) = kd;
     }
-    Matrix3x4d temp = mujoco_ang2real_ang(dof_pos);
-    
-    real_angles_ = temp;
-    kp_array_ = kp_temp;
-    kd_array_ = kd_temp;
+    Eigen::Map<Matrix3x4d>(block.position.data()) = mujoco_ang2real_ang(dof_pos);
+    Eigen::Map<Matrix3x4d>(block.velocity.data()) = mujoco_ang2real_ang(dof_vel);
+
+    // 三个矩阵一次发布, 实时循环不会取到位置与增益来自不同指令的组合
+    block.seq = ++lowcmd_seq_;
+    block.arrival_ns = arrival_ns;
+    lowcmd_.Store(block);
+    stage_latency_.Record(kStageDdsHandler, MonotonicNowNs() - arrival_ns);
+}
+
+/// @brief lowstate 线程回调, 实时控制循环运行时由 LowStatePublishThread 负责发布
+void Tangair_usb2can::PublishLowStateIdle()
+{
+    static thread_local bool rt_applied = false;
+    if (!rt_applied) {
+        ApplyThreadRtConfig("lowstate", realtime_config_.lowstate, PrefaultStackBytes());
+        rt_applied = true;
+    }
+
+    ReportLimitViolations();
+
+    if (rt_loop_active_)
+        return;
+    PublishLowState();
+}
+
+/// @brief 实时循环运行期间的 LowState 发布线程, 由 ControlStep 经 lowstate_fd_ 唤醒
+/// DDS 序列化与 Write() 在本线程完成, 不占用实时循环
+void Tangair_usb2can::LowStatePublishThread()
+{
+    ApplyThreadRtConfig("lowstate_pub", realtime_config_.lowstate, PrefaultStackBytes());
+    lowstate_thread_active_ = true;
+
+    struct pollfd pfd = {lowstate_fd_, POLLIN, 0};
+    while (running_) {
+        if (poll(&pfd, 1, -1) <= 0)
+            continue;
+        uint64_t requests = 0;
+        if (read(lowstate_fd_, &requests, sizeof(requests)) != sizeof(requests))
+            continue;
+        // 停止时的唤醒, 不再发布
+        if (!running_)
+            break;
+        PublishLowState();
+    }
+
+    lowstate_thread_active_ = false;
+    std::cout << "LowStatePublishThread Exit~~" << std::endl;
 }
 
 void Tangair_usb2can::PublishLowState()
 {   
     // std::cout << "[DEBUG] PublishLowState() called!" << std::endl;
-    std::vector<double> pos = GetMotorPositions();
-    std::vector<double> vel = GetMotorVelocity();
-
-    if ((int)pos.size() < num_motor_ || (int)vel.size() < num_motor_) {
-        std::cerr << "Please make sure match the start pos.\n";
-        motor_state_.position = {0.0, 1.6, -2.8, -0.0, 1.6, -2.8, -0.0, -1.6, 2.8, 0.0, -1.6, 2.8};
-        motor_state_.velocity = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    if (!lowstate_publisher)
         return;
-    }
+
+    const int64_t start_ns = MonotonicNowNs();
+    const MotorStateBlock state = GetMotorState();
+    const auto &pos = state.position;
+    const auto &vel = state.velocity;
 
     unitree_go::msg::dds_::LowState_ low_state_go_{};
 
@@ -323,22 +514,42 @@ void Tangair_usb2can::PublishLowState()
         low_state_go_.motor_state()[i].q() = pos[i];
         low_state_go_.motor_state()[i].dq() = vel[i];
         low_state_go_.motor_state()[i].tau_est() = 0;
+        low_state_go_.motor_state()[i].lost() = (state.stale_mask >> i) & 1u;
         
         // std::cout << "[Motor " << i << "] Position (q): " << pos[i] << std::endl;
     }
 
     // std::cout << "[CHECK] motor_state size = " << low_state_go_.motor_state().size() << std::endl;
 
-    low_state_go_.imu_state().quaternion()[0] = sensorData.quat.w();
-    low_state_go_.imu_state().quaternion()[1] = sensorData.quat.x();
-    low_state_go_.imu_state().quaternion()[2] = sensorData.quat.y();
-    low_state_go_.imu_state().quaternion()[3] = sensorData.quat.z();
+    const ImuState imu = imu_state_.Load();
+
+    low_state_go_.imu_state().quaternion()[0] = imu.quat[0];
+    low_state_go_.imu_state().quaternion()[1] = imu.quat[1];
+    low_state_go_.imu_state().quaternion()[2] = imu.quat[2];
+    low_state_go_.imu_state().quaternion()[3] = imu.quat[3];
 
-    low_state_go_.imu_state().gyroscope()[0] = sensorData.gyr[0];
-    low_state_go_.imu_state().gyroscope()[1] = sensorData.gyr[1];
-    low_state_go_.imu_state().gyroscope()[2] = sensorData.gyr[2];
+    low_state_go_.imu_state().gyroscope()[0] = imu.gyr[0];
+    low_state_go_.imu_state().gyroscope()[1] = imu.gyr[1];
+    low_state_go_.imu_state().gyroscope()[2] = imu.gyr[2];
+
+    low_state_go_.tick() = state.cycle;
 
     lowstate_publisher->Write(low_state_go_);
+
+    // 端到端: 快照中最早的新鲜样本 -> 发出
+    const int64_t end_ns = MonotonicNowNs();
+    int64_t oldest_ns = 0;
+    for (int i = 0; i < num_motor_; ++i)
+        if (!((state.stale_mask >> i) & 1u) && (oldest_ns == 0 || state.sample_ns[i] < oldest_ns))
+            oldest_ns = state.sample_ns[i];
+    if (oldest_ns != 0)
+        stage_latency_.Record(kStageRxToPublish, end_ns - oldest_ns);
+    // 同一个 IMU 样本只在第一次发出时计入
+    if (imu.timestamp_ns != 0 && imu.timestamp_ns != imu_published_ns_) {
+        stage_latency_.Record(kStageImuToPublish, end_ns - imu.timestamp_ns);
+        imu_published_ns_ = imu.timestamp_ns;
+    }
+    stage_latency_.Record(kStagePublish, end_ns - start_ns);
 }
 
 /*********************************       *** Main control related ***      ***********************************************/
@@ -347,27 +558,63 @@ void Tangair_usb2can::StartReadLoop() {
     if (running_) return;
     running_ = true;
 
-    _CAN_RX_device_0_thread = std::thread(&Tangair_usb2can::CAN_RX_device_0_thread, this);
+    if (realtime_config_.io_reactor.enabled)
+        StartIoReactor();
+    for (int a = 0; a < NumAdapters(); ++a)
+        if (!adapter_polled_[a]) {
+            rx_serviced_mask_.fetch_or(1u << a, std::memory_order_release);
+            can_rx_threads_.emplace_back(&Tangair_usb2can::CAN_RX_device_thread, this, a);
+        }
 }
 
 void Tangair_usb2can::StartPositionLoop() {
     if (running_) return;
     running_ = true;
 
-    _CAN_RX_device_0_thread = std::thread(&Tangair_usb2can::CAN_RX_device_0_thread, this);
+    if (realtime_config_.io_reactor.enabled)
+        StartIoReactor();
+    // 先标记各适配器已有接收线程, 实时循环中的使能序列不会与其同时接收
+    for (int a = 0; a < NumAdapters(); ++a)
+        if (!adapter_polled_[a]) {
+            rx_serviced_mask_.fetch_or(1u << a, std::memory_order_release);
+            can_rx_threads_.emplace_back(&Tangair_usb2can::CAN_RX_device_thread, this, a);
+        }
+    // 第1个适配器由实时循环直接发送
+    for (int a = 1; a < NumAdapters(); ++a)
+        can_tx_threads_.emplace_back(&Tangair_usb2can::CAN_TX_worker_thread, this, a);
+    tx_workers_active_ = !can_tx_threads_.empty();
+    if (lowstate_fd_ >= 0)
+        lowstate_pub_thread_ = std::thread(&Tangair_usb2can::LowStatePublishThread, this);
     _CAN_TX_position_thread = std::thread(&Tangair_usb2can::CAN_TX_position_thread, this);
 }
 
 void Tangair_usb2can::StopAllThreads() {
     if (!running_) return;
     running_ = false;
-    
-    IMU_Shutdown();
 
-    if (_CAN_RX_device_0_thread.joinable()) _CAN_RX_device_0_thread.join();
+    // 实时循环在一个周期内退出, 随即失能, 不等 IMU 与 RX 线程
+    // TX工作线程与 LowState 发布线程经 eventfd 立即唤醒退出, 不等 poll 超时
     if (_CAN_TX_position_thread.joinable()) _CAN_TX_position_thread.join();
+    tx_workers_active_ = false;
+    const uint64_t one = 1;
+    for (int fd : tx_worker_fd_)
+        if (fd >= 0)
+            (void)!write(fd, &one, sizeof(one));
+    for (auto &t : can_tx_threads_)
+        if (t.joinable()) t.join();
+    can_tx_threads_.clear();
+    if (lowstate_fd_ >= 0)
+        (void)!write(lowstate_fd_, &one, sizeof(one));
+    if (lowstate_pub_thread_.joinable()) lowstate_pub_thread_.join();
+
+    PrintMotorSequenceResult("disable", DISABLE_ALL_MOTOR(0));
+
+    IMU_Shutdown();
+
+    for (auto &t : can_rx_threads_)
+        if (t.joinable()) t.join();
+    can_rx_threads_.clear();
 
-    DISABLE_ALL_MOTOR(237);
     std::cout << "[Tangair] 所有執行緒已安全停止。\n";
 }
 
@@ -388,6 +635,9 @@ bool Tangair_usb2can::LoadConfigFromYAML(const std::string& filepath) {
         control_limits_.kp_max = ctrl["kp_max"].as<double>();
         control_limits_.kd_min = ctrl["kd_min"].as<double>();
         control_limits_.kd_max = ctrl["kd_max"].as<double>();
+        if (ctrl["violation_mode"])
+            control_limits_.violation_mode = ctrl["violation_mode"].as<std::string>() == "clamp"
+                                                 ? LimitViolationMode::kClamp : LimitViolationMode::kReject;
 
         auto joints = config["joint_limits"];
         std::vector<std::string> legs = { "FR", "FL", "RR", "RL" };
@@ -404,90 +654,161 @@ bool Tangair_usb2can::LoadConfigFromYAML(const std::string& filepath) {
             joint_limits_per_leg_[leg] = limits;
         }
 
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "[ERROR] Failed to load YAML config: " << e.what() << std::endl;
-        return false;
-    }
-}
-
-bool Tangair_usb2can::CheckPositionAndGainValidity(const Matrix3x4d& positions, 
-                                                   const Matrix3x4d& kp_array, 
-                                                   const Matrix3x4d& kd_array) {
-    const std::array<std::string, 4> leg_names = { "FR", "FL", "RR", "RL" };
-
-    for (int row = 0; row < 3; ++row) {  // 0: calf, 1: thigh, 2: hip
-        for (int col = 0; col < 4; ++col) {
-            double pos = positions(row, col);
-            double kp  = kp_array(row, col);
-            double kd  = kd_array(row, col);
-
-            const auto& leg_name = leg_names[col];
-            const auto& joint_limit = joint_limits_per_leg_.at(leg_name);
-
-            double pos_min, pos_max;
-
-            if (row == 2) { // hip
-                pos_min = joint_limit.hip.min;
-                pos_max = joint_limit.hip.max;
-            } else if (row == 1) { // thigh
-                pos_min = joint_limit.thigh.min;
-                pos_max = joint_limit.thigh.max;
-            } else { // calf
-                pos_min = joint_limit.calf.min;
-                pos_max = joint_limit.calf.max;
+        // 展开为扁平限位表, 运行中不再查 map
+        command_validator_.SetLimits(control_limits_, joint_limits_per_leg_);
+
+        // 可选
+        auto realtime = config["realtime"];
+        if (realtime) {
+            auto load_thread = [](const YAML::Node& node, ThreadRtConfig& cfg) {
+                if (!node) return;
+                if (node["cpu"])      cfg.cpu = node["cpu"].as<int>();
+                if (node["priority"]) cfg.priority = node["priority"].as<int>();
+            };
+
+            if (realtime["lock_memory"])       realtime_config_.lock_memory = realtime["lock_memory"].as<bool>();
+            if (realtime["prefault_stack_kb"]) realtime_config_.prefault_stack_kb = realtime["prefault_stack_kb"].as<int>();
+
+            auto loop = realtime["control_loop"];
+            if (loop) {
+                if (loop["rate_hz"])         realtime_config_.control_loop.rate_hz = loop["rate_hz"].as<int>();
+                if (loop["publish_divider"]) realtime_config_.control_loop.publish_divider = loop["publish_divider"].as<int>();
+                load_thread(loop, realtime_config_.control_loop.thread);
             }
 
-            if (!std::isfinite(pos) || pos < pos_min || pos > pos_max) {
-                std::cerr << "[ERROR] Invalid position (" << pos << ") at [" << row << ", " << col
-                          << "] (" << leg_name << "), limit: [" << pos_min << ", " << pos_max << "]\n";
-                return false;
+            auto reactor = realtime["io_reactor"];
+            if (reactor) {
+                if (reactor["enabled"]) realtime_config_.io_reactor.enabled = reactor["enabled"].as<bool>();
+                load_thread(reactor, realtime_config_.io_reactor.thread);
             }
 
-            if (!std::isfinite(kp) || kp < control_limits_.kp_min || kp > control_limits_.kp_max) {
-                std::cerr << "[ERROR] Invalid kp (" << kp << ") at [" << row << ", " << col
-                          << "] (" << leg_name << "), limit: [" << control_limits_.kp_min << ", " << control_limits_.kp_max << "]\n";
-                return false;
+            auto threads = realtime["threads"];
+            load_thread(threads["can_rx"], realtime_config_.can_rx);
+            load_thread(threads["can_tx"], realtime_config_.can_tx);
+            load_thread(threads["imu"], realtime_config_.imu);
+            load_thread(threads["xda"], realtime_config_.xda);
+            load_thread(threads["lowstate"], realtime_config_.lowstate);
+        }
+
+        // 可选, 缺省为 usb2can
+        auto load_transport = [](const YAML::Node& transport, CanTransportConfig& cfg) {
+            if (transport["type"])       cfg.type = transport["type"].as<std::string>();
+            if (transport["device"])     cfg.device = transport["device"].as<std::string>();
+            if (transport["interfaces"]) cfg.interfaces = transport["interfaces"].as<std::vector<std::string>>();
+
+            auto emu = transport["emulator"];
+            if (emu) {
+                CanEmulatorConfig& e = cfg.emulator;
+                if (emu["latency_us"]) e.latency_us = emu["latency_us"].as<int>();
+                if (emu["jitter_us"])  e.jitter_us = emu["jitter_us"].as<int>();
+                if (emu["loss_rate"])  e.loss_rate = emu["loss_rate"].as<double>();
+                if (emu["bitrate"])    e.bitrate = emu["bitrate"].as<int>();
+                if (emu["inertia"])    e.inertia = emu["inertia"].as<double>();
+                if (emu["damping"])    e.damping = emu["damping"].as<double>();
+                if (emu["seed"])       e.seed = emu["seed"].as<unsigned>();
+            }
+        };
+        auto transport = config["can_transport"];
+        if (transport)
+            load_transport(transport, can_transport_config_);
+
+        // 可选, 缺省为 can_transport 上两路can的默认布局; 各适配器未写的项沿用 can_transport
+        auto topology = config["can_topology"];
+        if (topology) {
+            CanTopologyConfig& cfg = can_topology_config_;
+            cfg = CanTopologyConfig();
+            for (const auto& adapter : topology["adapters"]) {
+                cfg.adapters.push_back(can_transport_config_);
+                load_transport(adapter, cfg.adapters.back());
             }
+            for (const auto& bus : topology["buses"]) {
+                CanBusConfig b;
+                if (bus["adapter"]) b.adapter = bus["adapter"].as<int>();
+                if (bus["channel"]) b.channel = bus["channel"].as<int>();
+                for (const auto& motor : bus["motors"]) {
+                    CanMotorConfig m;
+                    m.id = motor["id"].as<int>();
+                    m.joint = motor["joint"].as<int>();
+                    if (motor["type"]) m.type = motor["type"].as<std::string>();
+                    if (motor["sign"]) m.sign = motor["sign"].as<float>();
+                    b.motors.push_back(m);
+                }
+                cfg.buses.push_back(b);
+            }
+        }
 
-            if (!std::isfinite(kd) || kd < control_limits_.kd_min || kd > control_limits_.kd_max) {
-                std::cerr << "[ERROR] Invalid kd (" << kd << ") at [" << row << ", " << col
-                          << "] (" << leg_name << "), limit: [" << control_limits_.kd_min << ", " << control_limits_.kd_max << "]\n";
-                return false;
+        // 可选, 缺省为 hold (每周期重发最近一条指令)
+        auto interp = config["command_interpolation"];
+        if (interp) {
+            CommandInterpolationConfig& cfg = interpolation_config_;
+            if (interp["mode"]) {
+                const std::string mode = interp["mode"].as<std::string>();
+                if (mode == "linear")        cfg.mode = InterpolationMode::kLinear;
+                else if (mode == "cubic")    cfg.mode = InterpolationMode::kCubic;
+                else if (mode == "min_jerk") cfg.mode = InterpolationMode::kMinJerk;
+                else                         cfg.mode = InterpolationMode::kHold;
             }
+            if (interp["extrapolate_ms"])  cfg.extrapolate_ms = interp["extrapolate_ms"].as<double>();
+            if (interp["max_interval_ms"]) cfg.max_interval_ms = interp["max_interval_ms"].as<double>();
+        }
+
+        // 可选
+        auto sequence = config["motor_sequence"];
+        if (sequence) {
+            if (sequence["reply_timeout_us"]) motor_sequence_config_.reply_timeout_us = sequence["reply_timeout_us"].as<int>();
+            if (sequence["retries"])          motor_sequence_config_.retries = sequence["retries"].as<int>();
+        }
+
+        // 可选
+        auto stats = config["latency_stats"];
+        if (stats) {
+            if (stats["shared_memory"]) latency_stats_config_.shared_memory = stats["shared_memory"].as<bool>();
+            if (stats["shm_name"])      latency_stats_config_.shm_name = stats["shm_name"].as<std::string>();
+        }
+
+        // 可选, 缺省关闭
+        auto recorder = config["flight_recorder"];
+        if (recorder) {
+            FlightRecorderConfig& cfg = flight_recorder_config_;
+            if (recorder["enabled"])        cfg.enabled = recorder["enabled"].as<bool>();
+            if (recorder["path"])           cfg.path = recorder["path"].as<std::string>();
+            if (recorder["dump_path"])      cfg.dump_path = recorder["dump_path"].as<std::string>();
+            if (recorder["dump_seconds"])   cfg.dump_seconds = recorder["dump_seconds"].as<double>();
+            if (recorder["tx_records"])     cfg.tx_records = recorder["tx_records"].as<int>();
+            if (recorder["rx_records"])     cfg.rx_records = recorder["rx_records"].as<int>();
+            if (recorder["lowcmd_records"]) cfg.lowcmd_records = recorder["lowcmd_records"].as<int>();
+            if (recorder["imu_records"])    cfg.imu_records = recorder["imu_records"].as<int>();
         }
+
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Failed to load YAML config: " << e.what() << std::endl;
+        return false;
     }
+}
 
-    return true;
+/// @brief 只校验不处理, 超限 (含 NaN / Inf) 返回 false
+bool Tangair_usb2can::CheckPositionAndGainValidity(const Matrix3x4d& positions, 
+                                                   const Matrix3x4d& kp_array, 
+                                                   const Matrix3x4d& kd_array) {
+    return !command_validator_.Check(positions.data(), kp_array.data(), kd_array.data()).any();
 }
 
 void Tangair_usb2can::SetTargetPosition(const Matrix3x4d &positions, 
                                         const Matrix3x4d &kp_array, 
                                         const Matrix3x4d &kd_array) {
-    if (!CheckPositionAndGainValidity(positions, kp_array, kd_array)) {
-        std::cerr << "[SetTargetPosition] 檢查未通過，取消指令發送。\n";
+    // 按 violation_mode 丢弃或限幅, 超限报告由 ReportLimitViolations 在非实时线程打印
+    Matrix3x4d checked_positions = positions;
+    Matrix3x4d checked_kp = kp_array;
+    Matrix3x4d checked_kd = kd_array;
+    if (!command_validator_.Apply(checked_positions.data(), checked_kp.data(), checked_kd.data()))
         return;
-    }    
-
-    // FR
-    SetMotorTarget(USB2CAN0_CAN_Bus_2.ID_1_motor_send, positions(2, 0), kp_array(2, 0), kd_array(2, 0));
-    SetMotorTarget(USB2CAN0_CAN_Bus_2.ID_2_motor_send, positions(1, 0), kp_array(1, 0), kd_array(1, 0));
-    SetMotorTarget(USB2CAN0_CAN_Bus_2.ID_3_motor_send, positions(0, 0), kp_array(0, 0), kd_array(0, 0));
-
-    // FL
-    SetMotorTarget(USB2CAN0_CAN_Bus_2.ID_5_motor_send, positions(2, 1), kp_array(2, 1), kd_array(2, 1));
-    SetMotorTarget(USB2CAN0_CAN_Bus_2.ID_6_motor_send, positions(1, 1), kp_array(1, 1), kd_array(1, 1));
-    SetMotorTarget(USB2CAN0_CAN_Bus_2.ID_7_motor_send, positions(0, 1), kp_array(0, 1), kd_array(0, 1));
 
-    // RR
-    SetMotorTarget(USB2CAN0_CAN_Bus_1.ID_1_motor_send, positions(2, 2), kp_array(2, 2), kd_array(2, 2));
-    SetMotorTarget(USB2CAN0_CAN_Bus_1.ID_2_motor_send, positions(1, 2), kp_array(1, 2), kd_array(1, 2));
-    SetMotorTarget(USB2CAN0_CAN_Bus_1.ID_3_motor_send, positions(0, 2), kp_array(0, 2), kd_array(0, 2));
-
-    // RL
-    SetMotorTarget(USB2CAN0_CAN_Bus_1.ID_5_motor_send, positions(2, 3), kp_array(2, 3), kd_array(2, 3));
-    SetMotorTarget(USB2CAN0_CAN_Bus_1.ID_6_motor_send, positions(1, 3), kp_array(1, 3), kd_array(1, 3));
-    SetMotorTarget(USB2CAN0_CAN_Bus_1.ID_7_motor_send, positions(0, 3), kp_array(0, 3), kd_array(0, 3));
+    // 矩阵第 col 列为第 col 条腿 (FR FL RR RL), row 2 髋 / 1 大腿 / 0 小腿, 对应DDS序号 col * 3 + 2 - row
+    for (int j = 0; j < NUM_MOTOR; ++j) {
+        const int row = 2 - j % 3, col = j / 3;
+        SetMotorTarget(motor_send_[j], checked_positions(row, col), checked_kp(row, col), checked_kd(row, col));
+    }
 }
 
 void Tangair_usb2can::ResetPositionToZero()
@@ -506,295 +827,679 @@ void Tangair_usb2can::ResetPositionToZero()
     CAN_TX_ALL_MOTOR(120);
 }
 
-std::vector<double> Tangair_usb2can::GetMotorPositions() {
-    std::lock_guard<std::mutex> lock(motor_state_mutex);
-    return motor_state_.position;
+MotorStateBlock Tangair_usb2can::GetMotorState() const {
+    return motor_state_.Load();
 }
 
-std::vector<double> Tangair_usb2can::GetMotorVelocity() {
-    std::lock_guard<std::mutex> lock(motor_state_mutex);
-    return motor_state_.velocity;
+std::array<float, NUM_MOTOR> Tangair_usb2can::GetMotorPositions() const {
+    return motor_state_.Load().position;
 }
 
-std::vector<double> Tangair_usb2can::GetMotorTorque() {
-    std::lock_guard<std::mutex> lock(motor_state_mutex);
-    return motor_state_.torque;
+std::array<float, NUM_MOTOR> Tangair_usb2can::GetMotorVelocity() const {
+    return motor_state_.Load().velocity;
 }
 
+std::array<float, NUM_MOTOR> Tangair_usb2can::GetMotorTorque() const {
+    return motor_state_.Load().torque;
+}
+
+/// @brief 生成一次状态快照, 每个TX周期调用一次
+/// 本周期未收到反馈的关节沿用旧样本, 记入 stale_mask 与 missed_cycles
 void Tangair_usb2can::UpdateMotorState() {
-    motor_state_.position = GetMotorFloatVector("position");
-    motor_state_.velocity = GetMotorFloatVector("velocity");
-    motor_state_.torque   = GetMotorFloatVector("torque");
-}
-
-std::vector<double> Tangair_usb2can::GetMotorFloatVector(const std::string& field) {
-    std::vector<double> result;
-    const std::vector<std::pair<int, int>> motorMap = {
-        {2, 1}, {2, 2}, {2, 3}, {2, 5}, {2, 6}, {2, 7},
-        {1, 1}, {1, 2}, {1, 3}, {1, 5}, {1, 6}, {1, 7}
-    };
-
-    for (const auto& [bus_id, motor_id] : motorMap) {
-        auto& motor = (bus_id == 1 ? USB2CAN0_CAN_Bus_1 : USB2CAN0_CAN_Bus_2);
-        auto& recv = [&]() -> Motor_CAN_Recieve_Struct& {
-            switch (motor_id) {
-                case 1: return motor.ID_1_motor_recieve;
-                case 2: return motor.ID_2_motor_recieve;
-                case 3: return motor.ID_3_motor_recieve;
-                case 5: return motor.ID_5_motor_recieve;
-                case 6: return motor.ID_6_motor_recieve;
-                case 7: return motor.ID_7_motor_recieve;
-                default: throw std::runtime_error("Invalid motor ID");
-            }
-        }();
-
-        float val = 0;
-        if (field == "position") val = recv.current_position_f;
-        else if (field == "velocity") val = recv.current_speed_f;
-        else if (field == "torque") val = recv.current_torque_f;
-        else throw std::invalid_argument("Invalid field: " + field);
-
-        // 特定 motor 做反向處理
-        if ((bus_id == 2 && (motor_id == 2 || motor_id == 3)) ||
-            (bus_id == 1 && (motor_id == 1 || motor_id == 2 || motor_id == 3 || motor_id == 5))) {
-            val *= -1;
+    MotorStateBlock state;
+    state.cycle = tx_cycle_seq_.load(std::memory_order_acquire);
+    state.stale_mask = 0;
+    state.timestamp_ns = MonotonicNowNs();
+
+    // 单次遍历同时填写位置/速度/扭矩
+    for (int j = 0; j < NUM_MOTOR; ++j) {
+        const JointDescriptor &joint = joints_[j];
+
+        // 数值、周期号与接收时间取自同一帧反馈
+        const JointFeedback feedback = joint_feedback_[j].Load();
+        const bool fresh = feedback.cycle == state.cycle;
+
+        state.position[j] = joint.sign * feedback.position;
+        state.velocity[j] = joint.sign * feedback.velocity;
+        state.torque[j]   = joint.sign * feedback.torque;
+        state.sample_ns[j] = feedback.timestamp_ns;
+
+        if (!fresh) {
+            state.stale_mask |= 1u << j;
+            if (state.cycle != 0)
+                rx_missed_[j].fetch_add(1, std::memory_order_relaxed);
         }
-
-        result.push_back(val);
     }
 
-    return result;
+    motor_state_.Store(state);
 }
 
 
+/// @brief 实时控制循环, timerfd 定时, 每周期按 读状态 -> 指令 -> 发送 -> 发布 顺序执行
+/// 取代原先自由运行的TX循环; 发布拍只通知 lowstate 线程, RX线程仍负责阻塞读取与解码
 void Tangair_usb2can::CAN_TX_position_thread()
 {
     std::cout << "[THREAD] CAN_TX_position_thread start\n";
 
+    const ControlLoopConfig cfg = realtime_config_.control_loop;
+    const int rate_hz = std::min(std::max(cfg.rate_hz, kMinControlRateHz), kMaxControlRateHz);
+    const int64_t period_ns = 1000000000LL / rate_hz;
+    const int publish_divider = std::max(cfg.publish_divider, 1);
+
+    ApplyThreadRtConfig("can_rt_loop", cfg.thread, PrefaultStackBytes());
+
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (tfd < 0) {
+        std::cerr << "[ERROR] timerfd_create 失败: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    // 各电机确认使能后立即进入闭环
+    PrintMotorSequenceResult("enable", ENABLE_ALL_MOTOR(120));
+
+    // 绝对时间定时, 周期不随执行时间漂移
+    int64_t next_tick_ns = MonotonicNowNs() + period_ns;
+    struct itimerspec its = {};
+    its.it_interval.tv_sec = period_ns / 1000000000LL;
+    its.it_interval.tv_nsec = period_ns % 1000000000LL;
+    its.it_value.tv_sec = next_tick_ns / 1000000000LL;
+    its.it_value.tv_nsec = next_tick_ns % 1000000000LL;
+    timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, nullptr);
+
+    ResetRtLoopStats();
+    rt_loop_active_ = true;
+
     auto last_time_tx = high_resolution_clock::now();
     int count_tx = 0;
+    uint64_t cycle = 0;
 
-    ENABLE_ALL_MOTOR(120);
-    
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    // 同时等待定时器与 "12路反馈到齐" 事件
+    struct pollfd pfds[2] = {{tfd, POLLIN, 0}, {rx_complete_fd_, POLLIN, 0}};
+    uint32_t snapshot_cycle = tx_cycle_seq_.load(std::memory_order_relaxed);
 
     while (running_) {
-        count_tx++;
+        if (poll(pfds, 2, 100) <= 0)
+            continue;
+
+        // 反馈到齐: 立即生成本周期快照, 不必等到下一拍
+        if (pfds[1].revents & POLLIN) {
+            uint64_t events = 0;
+            (void)!read(rx_complete_fd_, &events, sizeof(events));
+            // 事件可能来自上一周期, 以当前周期的待收掩码为准
+            if (rx_pending_mask_.load(std::memory_order_acquire) == 0 &&
+                tx_cycle_seq_.load(std::memory_order_relaxed) != snapshot_cycle) {
+                UpdateMotorState();
+                snapshot_cycle = tx_cycle_seq_.load(std::memory_order_relaxed);
+            }
+        }
 
-        // PrintMatrix("real_angles_", real_angles_);
-        // PrintMatrix("kp_array_ (as kp)", kp_array_);
-        // PrintMatrix("kd_array_ (as kd)", kd_array_);
+        if (!(pfds[0].revents & POLLIN))
+            continue;
 
-        SetTargetPosition(real_angles_, kp_array_, kd_array_);
+        uint64_t expirations = 0;
+        if (read(tfd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            continue;
 
-        CAN_TX_ALL_MOTOR(120);
+        const int64_t wake_ns = MonotonicNowNs();
+        rt_jitter_.Record(wake_ns - next_tick_ns);
+        if (expirations > 1)
+            rt_missed_ticks_.fetch_add(expirations - 1, std::memory_order_relaxed);
+        next_tick_ns += period_ns * (int64_t)expirations;
 
-        /********************************* ***TX Finish*** ***********************************************/
+        count_tx++;
+
+        // 1. 读状态: 截止到本拍仍未到齐的关节记入 stale_mask
+        if (tx_cycle_seq_.load(std::memory_order_relaxed) != snapshot_cycle) {
+            UpdateMotorState();
+            snapshot_cycle = tx_cycle_seq_.load(std::memory_order_relaxed);
+        }
+
+        // 2. 指令 3. 发送 4. 发布
+        ControlStep(cycle++ % publish_divider == 0);
+
+        const int64_t exec_ns = MonotonicNowNs() - wake_ns;
+        rt_exec_.Record(exec_ns);
+        if (exec_ns > period_ns)
+            rt_overruns_.fetch_add(1, std::memory_order_relaxed);
+        rt_cycles_.fetch_add(1, std::memory_order_relaxed);
 
-        std::lock_guard<std::mutex> lock(motor_state_mutex);
-        UpdateMotorState();
-        
-        // std::this_thread::sleep_for(std::chrono::milliseconds(1));
         auto now_tx = high_resolution_clock::now();
         auto duration_tx = duration_cast<seconds>(now_tx - last_time_tx).count();
         if (duration_tx >= 1) {
-            std::cout << "[Frequency] CAN TX = " << count_tx << " Hz" << std::endl;
+            TxCycleStats stats = GetTxCycleStats();
+            RtLoopStats rt = GetRtLoopStats();
+            uint64_t rx_missed = 0;
+            for (int j = 0; j < NUM_MOTOR; ++j)
+                rx_missed += rx_missed_[j].load(std::memory_order_relaxed);
+            std::cout << "[Frequency] CAN TX = " << count_tx << " Hz"
+                      << ", cycle(us) last/min/avg/max = "
+                      << stats.last_ns / 1000 << "/" << stats.min_ns / 1000 << "/"
+                      << stats.avg_ns / 1000 << "/" << stats.max_ns / 1000
+                      << ", jitter(us) p99/max = " << rt.jitter_p99_ns / 1000 << "/" << rt.jitter_max_ns / 1000
+                      << ", exec(us) p99/max = " << rt.exec_p99_ns / 1000 << "/" << rt.exec_max_ns / 1000
+                      << ", overruns = " << rt.overruns << ", missed = " << rt.missed_ticks
+                      << ", stale replies total = " << rx_missed;
+            if (NumAdapters() > 1)
+                std::cout << ", tx worker skipped = " << tx_worker_skipped_.load(std::memory_order_relaxed);
+            std::cout << std::endl;
+            ResetTxCycleStats();
             count_tx = 0;
             last_time_tx = now_tx;
         }
     }
 
+    rt_loop_active_ = false;
+    close(tfd);
+
     std::cout << "CAN_TX_position_thread Exit~~" << std::endl;
 }
 
-/// @brief can设备0，接收线程函数
-void Tangair_usb2can::CAN_RX_device_0_thread()
+/// @brief 实时循环每拍在读状态之后的部分
+void Tangair_usb2can::ControlStep(bool publish)
 {
+    // 本周期是否带有新的 LowCmd
+    const int64_t start_ns = MonotonicNowNs();
+    const LowCmdBlock cmd = lowcmd_.Load();
+    const bool new_cmd = cmd.seq != tx_cmd_seq_;
+    if (new_cmd)
+        stage_latency_.Record(kStageCmdWait, start_ns - cmd.arrival_ns);
+
+    // 2. 指令: 新指令先按 violation_mode 校验, 丢弃的指令不进入插值, 电机继续跟随上一条
+    // 插值得到本周期的设定值, 尚未收到 LowCmd 时电机保持原目标
+    if (new_cmd) {
+        LowCmdBlock checked = cmd;
+        if (command_validator_.Apply(checked.position.data(), checked.kp.data(), checked.kd.data()) &&
+            command_interpolator_.Push(checked.position.data(), checked.velocity.data(), cmd.arrival_ns, start_ns)) {
+            active_kp_ = checked.kp;
+            active_kd_ = checked.kd;
+        }
+    }
+    Matrix3x4d setpoint;
+    if (command_interpolator_.Sample(start_ns, setpoint.data())) {
+        SetTargetPosition(setpoint, Matrix3x4d::Map(active_kp_.data()), Matrix3x4d::Map(active_kd_.data()));
+        stage_latency_.Record(kStageValidate, MonotonicNowNs() - start_ns);
+    }
+
+    // 3. 发送
+    CAN_TX_ALL_MOTOR(120);
+    if (new_cmd) {
+        stage_latency_.Record(kStageCmdToTx, MonotonicNowNs() - cmd.arrival_ns);
+        tx_cmd_seq_ = cmd.seq;
+    }
+
+    /********************************* ***TX Finish*** ***********************************************/
+
+    // 4. 发布: 有 lowstate 线程时只发通知, DDS 发送不计入本拍执行时间
+    if (publish) {
+        if (lowstate_thread_active_.load(std::memory_order_relaxed) && lowstate_fd_ >= 0) {
+            const uint64_t one = 1;
+            (void)!write(lowstate_fd_, &one, sizeof(one));
+        } else {
+            PublishLowState();
+        }
+    }
+}
+
+RtLoopStats Tangair_usb2can::GetRtLoopStats() const
+{
+    RtLoopStats stats;
+    stats.cycles = rt_cycles_.load(std::memory_order_relaxed);
+    stats.overruns = rt_overruns_.load(std::memory_order_relaxed);
+    stats.missed_ticks = rt_missed_ticks_.load(std::memory_order_relaxed);
+    stats.jitter_p50_ns = rt_jitter_.Percentile(0.50);
+    stats.jitter_p99_ns = rt_jitter_.Percentile(0.99);
+    stats.jitter_max_ns = rt_jitter_.Max();
+    stats.exec_p50_ns = rt_exec_.Percentile(0.50);
+    stats.exec_p99_ns = rt_exec_.Percentile(0.99);
+    stats.exec_max_ns = rt_exec_.Max();
+    return stats;
+}
+
+void Tangair_usb2can::ResetRtLoopStats()
+{
+    rt_cycles_ = 0;
+    rt_overruns_ = 0;
+    rt_missed_ticks_ = 0;
+    rt_jitter_.Reset();
+    rt_exec_.Reset();
+}
+
+/// @brief 一个适配器的接收线程函数
+void Tangair_usb2can::CAN_RX_device_thread(int adapter)
+{
+    const std::string name = "can_rx" + std::to_string(adapter);
+    ApplyThreadRtConfig(name.c_str(), realtime_config_.can_rx, PrefaultStackBytes());
+
     auto last_time_rx = high_resolution_clock::now();
     int count_rx = 0;
+    int reads_rx = 0;
+
+    CanFrame rx_frames[kRxBatch];
+    CanTransport &transport = *can_transports_[adapter];
 
     while (running_)
     {   
-        uint8_t channel;
-        FrameInfo info_rx;
-        uint8_t data_rx[8] = {0};
-
-        // 阻塞1s接收
-        int recieve_re = readUSBCAN(USB2CAN0_, &channel, &info_rx, data_rx, 1e6);
+        // 最多阻塞1s, 一次取走适配器已缓存的全部帧
+        int n = transport.Receive(rx_frames, kRxBatch, 1000000);
         // 接收到数据
-        if (recieve_re != -1)
+        if (n > 0)
         {   
-            count_rx++;
-            // 解码
-            CAN_DEV0_RX.ERR = data_rx[0]>>4&0X0F;
-            
-            CAN_DEV0_RX.current_position = (data_rx[1]<<8)|data_rx[2]; //电机位置数据
-			CAN_DEV0_RX.current_speed  = (data_rx[3]<<4)|(data_rx[4]>>4); //电机速度数据
-			CAN_DEV0_RX.current_torque = ((data_rx[4]&0xF)<<8)|data_rx[5]; //电机扭矩数据
-			CAN_DEV0_RX.current_temp_MOS  = data_rx[6];
-            CAN_DEV0_RX.current_temp_Rotor  = data_rx[7];
-  
-            if (channel == 1) // 模块0，can1
-            {
-                switch (info_rx.canID)
-                {
-                case 0X11:
-                {   
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_1.ID_1_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_1.ID_1_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_1.ID_1_motor_recieve = CAN_DEV0_RX;
-                   
-                    break;
-                }
-                case 0X12:
-                {   
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_1.ID_2_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_1.ID_2_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_1.ID_2_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-                case 0X13:
-                {   
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_1.ID_3_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_1.ID_3_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_1.ID_3_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-                case 0X15:
-                {   
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_1.ID_5_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_1.ID_5_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_1.ID_5_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-                case 0X16:
-                {   
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_1.ID_6_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_1.ID_6_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_1.ID_6_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-                case 0X17:
-                {   
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_1.ID_7_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_1.ID_7_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_1.ID_7_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-                default:
-                    break;
-                }
-            }
-            else if (channel == 2) // 模块0，can2
-            {
-                switch (info_rx.canID)
-                {
-                case 0X11:
-                {   
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_2.ID_1_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_2.ID_1_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_2.ID_1_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-                case 0X12:
-                {
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_2.ID_2_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_2.ID_2_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_2.ID_2_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-                case 0X13:
-                {
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_2.ID_3_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_2.ID_3_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_2.ID_3_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-                case 0X15:
-                {   
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_2.ID_5_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_2.ID_5_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_2.ID_5_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-                case 0X16:
-                {   
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_2.ID_6_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_2.ID_6_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_2.ID_6_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-                case 0X17:
-                {   
-                    CAN_DEV0_RX.current_position_f = uint_to_float(CAN_DEV0_RX.current_position, (P_MIN), (P_MAX), 16);
-                    CAN_DEV0_RX.current_speed_f = uint_to_float(CAN_DEV0_RX.current_speed, (V_MIN), (V_MAX), 12);    
-                    CAN_DEV0_RX.current_torque_f = uint_to_float(CAN_DEV0_RX.current_torque, (USB2CAN0_CAN_Bus_2.ID_7_motor_send.Tau_Min), (USB2CAN0_CAN_Bus_2.ID_7_motor_send.Tau_Max), 12);
-                    USB2CAN0_CAN_Bus_2.ID_7_motor_recieve = CAN_DEV0_RX;
-                    break;
-                }
-               
-                default:
-                    break;
-                }
-            }
+            count_rx += n;
+            ++reads_rx;
+            // 整批解码
+            CAN_RX_DecodeBatch(rx_frames, n, adapter);
+
             auto now_rx = high_resolution_clock::now();
             auto duration_rx = duration_cast<seconds>(now_rx - last_time_rx).count();
             if (duration_rx >= 1) {
-            std::cout << "[Frequency] CAN RX = " << count_rx / 12 << " Hz" << std::endl;
+            PrintRxRate(adapter, count_rx, reads_rx);
             count_rx = 0;
+            reads_rx = 0;
             last_time_rx = now_rx;
             }
         }
     }
-    std::cout << "CAN_RX_device_0_thread  Exit~~" << std::endl;
+    rx_serviced_mask_.fetch_and(~(1u << adapter), std::memory_order_release);
+    std::cout << "CAN_RX_device_thread " << adapter << " Exit~~" << std::endl;
+}
+
+/// @brief 本适配器上的关节数, 用于换算反馈频率
+int Tangair_usb2can::AdapterJointCount(int adapter) const
+{
+    int num_joints = 0;
+    for (const JointDescriptor &joint : joints_)
+        num_joints += joint.adapter == adapter;
+    return std::max(num_joints, 1);
+}
+
+/// @brief 每个电机的反馈频率与平均每次读取的帧数, frames / reads 为统计窗口内的累计值
+void Tangair_usb2can::PrintRxRate(int adapter, int frames, int reads) const
+{
+    std::cout << "[Frequency] CAN RX dev" << adapter << " = " << frames / AdapterJointCount(adapter) << " Hz, "
+              << std::fixed << std::setprecision(1) << (double)frames / std::max(reads, 1) << " frames/read"
+              << std::defaultfloat << std::endl;
+}
+
+/// @brief 创建 io_reactor 线程, 已在运行时直接返回; 任一描述符登记失败则整体退回各自的线程
+bool Tangair_usb2can::StartIoReactor()
+{
+    if (io_reactor_thread_.joinable())
+        return true;
+    if (!io_reactor_.Open())
+        return false;
+
+    bool ok = true;
+    for (int a = 0; a < NumAdapters() && ok; ++a) {
+        const std::vector<int> fds = can_transports_[a]->PollFds();
+        if (fds.empty()) {
+            std::cout << "[INFO] io_reactor: " << can_transports_[a]->Name() << " dev" << a
+                      << " 没有可 poll 的描述符, 使用 can_rx 线程" << std::endl;
+            continue;
+        }
+        for (int fd : fds)
+            ok = ok && io_reactor_.Add(fd, [this, a] { DrainCanAdapter(a); });
+        adapter_polled_[a] = 1;
+    }
+
+    // XDA 的 DataPoller 独占串口并负责组包, 这里登记回调的 eventfd, 每个完整样本唤醒一次
+    ok = ok && io_reactor_.Add(callback.eventFd(), [this] {
+        callback.acknowledgeEvent();
+        DrainImuPackets();
+    });
+
+    io_rate_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct itimerspec spec = {{1, 0}, {1, 0}};
+    ok = ok && io_rate_fd_ >= 0 && timerfd_settime(io_rate_fd_, 0, &spec, nullptr) == 0 &&
+         io_reactor_.Add(io_rate_fd_, [this] { PrintIoReactorRate(); });
+
+    if (!ok) {
+        std::cerr << "[ERROR] io_reactor 初始化失败, 使用 can_rx / imu 线程" << std::endl;
+        StopIoReactor();
+        return false;
+    }
+
+    io_rx_count_.assign(can_transports_.size(), 0);
+    io_rx_reads_.assign(can_transports_.size(), 0);
+    for (int a = 0; a < NumAdapters(); ++a)
+        if (adapter_polled_[a])
+            rx_serviced_mask_.fetch_or(1u << a, std::memory_order_release);
+    io_reactor_thread_ = std::thread(&Tangair_usb2can::IoReactorThread, this);
+    return true;
+}
+
+void Tangair_usb2can::StopIoReactor()
+{
+    if (io_reactor_thread_.joinable()) {
+        io_reactor_.Stop();
+        io_reactor_thread_.join();
+        for (int a = 0; a < NumAdapters(); ++a)
+            if (adapter_polled_[a])
+                rx_serviced_mask_.fetch_and(~(1u << a), std::memory_order_release);
+    }
+    io_reactor_.Close();
+    if (io_rate_fd_ >= 0)
+        close(io_rate_fd_);
+    io_rate_fd_ = -1;
+    std::fill(adapter_polled_.begin(), adapter_polled_.end(), 0);
+}
+
+/// @brief 单线程 I/O: CAN 反馈与 IMU 样本都在本线程内解码
+void Tangair_usb2can::IoReactorThread()
+{
+    ApplyThreadRtConfig("io_reactor", realtime_config_.io_reactor.thread, PrefaultStackBytes());
+    io_reactor_.Run();
+    std::cout << "IoReactorThread Exit~~" << std::endl;
+}
+
+/// @brief 取出一个适配器上已到达的全部反馈帧并解码, 不阻塞
+void Tangair_usb2can::DrainCanAdapter(int adapter)
+{
+    CanFrame rx_frames[kRxBatch];
+    CanTransport &transport = *can_transports_[adapter];
+
+    int n;
+    while ((n = transport.Receive(rx_frames, kRxBatch, 0)) > 0) {
+        io_rx_count_[adapter] += n;
+        ++io_rx_reads_[adapter];
+        CAN_RX_DecodeBatch(rx_frames, n, adapter);
+    }
+}
+
+void Tangair_usb2can::PrintIoReactorRate()
+{
+    uint64_t expirations = 0;
+    (void)!read(io_rate_fd_, &expirations, sizeof(expirations));
+
+    for (int a = 0; a < NumAdapters(); ++a) {
+        if (!adapter_polled_[a] || io_rx_count_[a] == 0)
+            continue;
+        PrintRxRate(a, io_rx_count_[a], io_rx_reads_[a]);
+        io_rx_count_[a] = 0;
+        io_rx_reads_[a] = 0;
+    }
+}
+
+/// @brief 第2个及以后适配器的发送线程, 实时循环编码完成后唤醒, 按本适配器各总线的节拍发送
+void Tangair_usb2can::CAN_TX_worker_thread(int adapter)
+{
+    const std::string name = "can_tx" + std::to_string(adapter);
+    ApplyThreadRtConfig(name.c_str(), realtime_config_.can_tx, PrefaultStackBytes());
+
+    struct pollfd pfd = {tx_worker_fd_[adapter], POLLIN, 0};
+    uint32_t last_cycle = 0;
+    while (running_) {
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+        uint64_t cycles = 0;
+        if (read(tx_worker_fd_[adapter], &cycles, sizeof(cycles)) != sizeof(cycles))
+            continue;
+        // 停止时的唤醒, 不再发送
+        if (!running_)
+            break;
+        // 积压了多个周期时只发最新一个
+        if (cycles > 1)
+            tx_worker_skipped_.fetch_add(cycles - 1, std::memory_order_relaxed);
+        // 取本周期负载的副本, 发送期间实时循环可以发布下一周期
+        const TxWorkerCycle work = tx_worker_cycle_.Load();
+        if (work.cycle == last_cycle)
+            continue;
+        last_cycle = work.cycle;
+        CAN_TX_Adapter(adapter, work.payload, work.cycle, work.delay_us);
+    }
+    std::cout << "CAN_TX_worker_thread " << adapter << " Exit~~" << std::endl;
+}
+
+/// @brief 单帧解码, 供回放与基准测试使用
+/// @param channel 适配器上的通道号
+/// @param canID 反馈帧ID, 0x11~0x1F
+/// @param data 8字节数据
+void Tangair_usb2can::CAN_RX_Decode(uint8_t channel, uint32_t canID, const uint8_t *data, int64_t timestamp_ns, int adapter)
+{
+    CanFrame frame;
+    frame.channel = channel;
+    frame.can_id = canID;
+    frame.dlc = 8;
+    std::memcpy(frame.data, data, 8);
+    frame.timestamp_ns = timestamp_ns;
+    frame.hw_timestamp_ns = 0;
+    CAN_RX_DecodeBatch(&frame, 1, adapter);
+}
+
+/// @brief 一次读取的全部反馈帧解码, 查表得到目标结构体, 无分配
+/// 周期屏障的掩码更新与唤醒在整批之后只做一次
+void Tangair_usb2can::CAN_RX_DecodeBatch(const CanFrame *frames, int count, int adapter)
+{
+    if (count <= 0 || adapter < 0 || adapter >= (int)rx_decode_table_.size())
+        return;
+
+    const RxDecodeTable &table = rx_decode_table_[adapter];
+    const int64_t batch_ns = MonotonicNowNs();
+    uint32_t fresh_mask = 0;
+    uint32_t replied_mask = 0;
+
+    for (int i = 0; i < count; ++i) {
+        const CanFrame &frame = frames[i];
+        if (frame.channel > kMaxChannels)
+            continue;
+
+        const uint8_t *data = frame.data;
+        const uint32_t canID = frame.can_id;
+        const int64_t now_ns = frame.timestamp_ns ? frame.timestamp_ns : batch_ns;
+        flight_recorder_.Append(kFlightStreamRx, kFlightRecordRxFrame, FlightChannel(adapter, frame.channel), canID, data, 8, now_ns);
+
+        const uint32_t slot = ((canID & ~0x0Fu) == DM_FEEDBACK_ID_BASE) ? (canID & 0x0F) : 0;
+        const CAN_RX_Decode_Struct &entry = table[frame.channel][slot];
+        if (entry.joint < 0)
+            continue;
+        Motor_CAN_Recieve_Struct &rx = *entry.recv;
+
+        rx.ERR = data[0]>>4&0X0F;
+
+        rx.current_position = (data[1]<<8)|data[2]; //电机位置数据
+        rx.current_speed  = (data[3]<<4)|(data[4]>>4); //电机速度数据
+        rx.current_torque = ((data[4]&0xF)<<8)|data[5]; //电机扭矩数据
+        rx.current_temp_MOS  = data[6];
+        rx.current_temp_Rotor  = data[7];
+
+        rx.current_position_f = rx.current_position * P_SCALE_RX + P_MIN;
+        rx.current_speed_f = rx.current_speed * V_SCALE_RX + V_MIN;
+        rx.current_torque_f = rx.current_torque * entry.t_scale + entry.t_offset;
+
+        // 本周期该关节的指令帧已发出且反馈在其之后到达, 才算本周期的样本
+        const int j = entry.joint;
+        const uint32_t cycle = tx_cycle_seq_.load(std::memory_order_acquire);
+        const TxSentStamp sent = tx_sent_[j].Load();
+        const int64_t sent_ns = sent.sent_ns;
+        const bool fresh = sent.cycle == cycle && sent_ns != 0 && now_ns >= sent_ns;
+
+        rx.timestamp_ns = now_ns;
+        rx.cycle = fresh ? cycle : cycle - 1;
+        joint_feedback_[j].Store({rx.current_position_f, rx.current_speed_f, rx.current_torque_f, rx.cycle, now_ns});
+        rx_time_ns_[j].store(now_ns, std::memory_order_relaxed);
+        rx_cycle_[j].store(rx.cycle, std::memory_order_release);
+        rx_replies_[j].fetch_add(1, std::memory_order_relaxed);
+        rx_state_[j].store(rx.ERR, std::memory_order_relaxed);
+        rx_ack_seq_[j].fetch_add(1, std::memory_order_release);
+        replied_mask |= 1u << j;
+
+        if (!fresh)
+            continue;
+
+        rx_latency_[j].Record(now_ns - sent_ns);
+        fresh_mask |= 1u << j;
+    }
+
+    // 到达 -> 解码完成, 整批共用一个结束时间
+    const int64_t end_ns = MonotonicNowNs();
+    for (int i = 0; i < count; ++i)
+        stage_latency_.Record(kStageRxDecode, end_ns - (frames[i].timestamp_ns ? frames[i].timestamp_ns : batch_ns));
+
+    // 使能等序列正在等待其中的电机
+    if ((replied_mask & reply_wait_mask_.load(std::memory_order_acquire)) && reply_fd_ >= 0) {
+        const uint64_t one = 1;
+        (void)!write(reply_fd_, &one, sizeof(one));
+    }
+
+    if (fresh_mask == 0)
+        return;
+
+    // 最后一路到齐时唤醒实时循环
+    const uint32_t prev = rx_pending_mask_.fetch_and(~fresh_mask, std::memory_order_acq_rel);
+    if (prev != 0 && (prev & ~fresh_mask) == 0 && rx_complete_fd_ >= 0) {
+        const uint64_t one = 1;
+        (void)!write(rx_complete_fd_, &one, sizeof(one));
+    }
+}
+
+MotorReplyStats Tangair_usb2can::GetMotorReplyStats(int dds_index) const
+{
+    MotorReplyStats stats;
+    if (dds_index < 0 || dds_index >= NUM_MOTOR)
+        return stats;
+
+    stats.replies = rx_replies_[dds_index].load(std::memory_order_relaxed);
+    stats.missed_cycles = rx_missed_[dds_index].load(std::memory_order_relaxed);
+    stats.last_cycle = rx_cycle_[dds_index].load(std::memory_order_acquire);
+    stats.last_rx_ns = rx_time_ns_[dds_index].load(std::memory_order_relaxed);
+    stats.latency_p50_ns = rx_latency_[dds_index].Percentile(0.50);
+    stats.latency_p99_ns = rx_latency_[dds_index].Percentile(0.99);
+    stats.latency_max_ns = rx_latency_[dds_index].Max();
+    return stats;
+}
+
+void Tangair_usb2can::ResetMotorReplyStats()
+{
+    for (int j = 0; j < NUM_MOTOR; ++j) {
+        rx_replies_[j] = 0;
+        rx_missed_[j] = 0;
+        rx_latency_[j].Reset();
+    }
 }
 
 /*****************************************************************************************************/
 /*********************************       ***电机相关***      ***********************************************/
 /*****************************************************************************************************/
 
-void Tangair_usb2can::USB2CAN_CAN_Bus_inti_set(USB2CAN_CAN_Bus_Struct *CAN_Bus)
+/// @brief 由 can_topology 生成运行时关节表与各总线的发送顺序
+/// 校验: 适配器与通道号在范围内, 电机ID 1~15, 12个关节各出现一次, 同一总线上ID不重复
+void Tangair_usb2can::BuildCanTopology()
 {
-    CAN_Bus->ID_1_motor_send.id = 0X01;
-    CAN_Bus->ID_1_motor_send.Tau_Min = T_MIN_8006;
-    CAN_Bus->ID_1_motor_send.Tau_Max = T_MAX_8006;
+    // 默认: 单适配器, can2 前腿 / can1 后腿, 每路按 髋 -> 大腿 -> 小腿 两腿交替
+    static const std::vector<std::vector<int>> kDefaultBusJoints = {{0, 3, 1, 4, 2, 5}, {6, 9, 7, 10, 8, 11}};
 
-    CAN_Bus->ID_2_motor_send.id = 0X02;
-    CAN_Bus->ID_2_motor_send.Tau_Min = T_MIN_8006;
-    CAN_Bus->ID_2_motor_send.Tau_Max = T_MAX_8006;
+    const CanTopologyConfig &cfg = can_topology_config_;
+    if (cfg.buses.empty()) {
+        joints_ = JOINT_MAP;
+        bus_joint_order_ = kDefaultBusJoints;
+        return;
+    }
 
-    CAN_Bus->ID_3_motor_send.id = 0X03;
-    CAN_Bus->ID_3_motor_send.Tau_Min = T_MIN_8009;
-    CAN_Bus->ID_3_motor_send.Tau_Max = T_MAX_8009;
+    std::array<JointDescriptor, NUM_MOTOR> joints = JOINT_MAP;
+    std::vector<std::vector<int>> order;
+    uint32_t seen = 0;
+    std::string error;
 
-    CAN_Bus->ID_5_motor_send.id = 0X05;
-    CAN_Bus->ID_5_motor_send.Tau_Min = T_MIN_8006;
-    CAN_Bus->ID_5_motor_send.Tau_Max = T_MAX_8006;
+    for (const CanBusConfig &bus : cfg.buses) {
+        if (bus.adapter < 0 || bus.adapter >= NumAdapters()) {
+            error = "bus adapter " + std::to_string(bus.adapter) + " out of range";
+            break;
+        }
+        if (bus.channel < 1 || bus.channel > kMaxChannels) {
+            error = "bus channel " + std::to_string(bus.channel) + " out of range";
+            break;
+        }
 
-    CAN_Bus->ID_6_motor_send.id = 0X06;
-    CAN_Bus->ID_6_motor_send.Tau_Min = T_MIN_8006;
-    CAN_Bus->ID_6_motor_send.Tau_Max = T_MAX_8006;
+        std::vector<int> bus_order;
+        uint32_t bus_ids = 0;
+        for (const CanMotorConfig &m : bus.motors) {
+            if (m.joint < 0 || m.joint >= NUM_MOTOR || ((seen >> m.joint) & 1u)) {
+                error = "joint " + std::to_string(m.joint) + " invalid or mapped twice";
+                break;
+            }
+            if (m.id < 1 || m.id >= kNumRxIds || ((bus_ids >> m.id) & 1u)) {
+                error = "motor id " + std::to_string(m.id) + " invalid or repeated on one bus";
+                break;
+            }
+            if (m.type != "DM8006" && m.type != "DM8009") {
+                error = "unknown motor type " + m.type;
+                break;
+            }
+            joints[m.joint] = {(uint8_t)bus.channel, (uint8_t)m.id, m.sign, (uint8_t)m.joint,
+                               m.type == "DM8009" ? MOTOR_DM8009 : MOTOR_DM8006, (uint8_t)bus.adapter};
+            seen |= 1u << m.joint;
+            bus_ids |= 1u << m.id;
+            bus_order.push_back(m.joint);
+        }
+        if (!error.empty())
+            break;
+        order.push_back(bus_order);
+    }
+    if (error.empty() && seen != kAllJointsMask)
+        error = "not all 12 joints are mapped";
 
-    CAN_Bus->ID_7_motor_send.id = 0X07;
-    CAN_Bus->ID_7_motor_send.Tau_Min = T_MIN_8009;
-    CAN_Bus->ID_7_motor_send.Tau_Max = T_MAX_8009;
+    if (!error.empty()) {
+        std::cerr << "[ERROR] can_topology: " << error << ", using the default layout" << std::endl;
+        joints_ = JOINT_MAP;
+        bus_joint_order_ = kDefaultBusJoints;
+        return;
+    }
+    joints_ = joints;
+    bus_joint_order_ = order;
 }
 
 void Tangair_usb2can::USB2CAN_CAN_Bus_Init()
 {
-    USB2CAN_CAN_Bus_inti_set(&USB2CAN0_CAN_Bus_1);
-    USB2CAN_CAN_Bus_inti_set(&USB2CAN0_CAN_Bus_2);
+    BuildCanTopology();
+
+    for (int j = 0; j < NUM_MOTOR; ++j) {
+        Motor_CAN_Send_Struct &motor = motor_send_[j];
+        motor = {};
+        motor.id = joints_[j].can_id;
+        motor.Tau_Min = joints_[j].type == MOTOR_DM8009 ? T_MIN_8009 : T_MIN_8006;
+        motor.Tau_Max = joints_[j].type == MOTOR_DM8009 ? T_MAX_8009 : T_MAX_8006;
+    }
+
+    CAN_TX_Schedule_Init();
+    CAN_RX_Decode_Init();
+}
+
+/// @brief RX解码表初始化, 扭矩换算参数取自各电机的 Tau_Min/Tau_Max (DM8006/DM8009)
+void Tangair_usb2can::CAN_RX_Decode_Init()
+{
+    CAN_RX_Decode_Struct discard = {nullptr, 0.0f, 0.0f, -1};
+    rx_decode_table_.resize(can_transports_.size());
+    for (RxDecodeTable &table : rx_decode_table_)
+        for (auto &channel_table : table)
+            channel_table.fill(discard);
+
+    for (int j = 0; j < NUM_MOTOR; ++j) {
+        const JointDescriptor &joint = joints_[j];
+        const Motor_CAN_Send_Struct &send = motor_send_[j];
+        rx_decode_table_[joint.adapter][joint.bus][joint.can_id & 0x0F] = {
+            &motor_recv_[j],
+            (send.Tau_Max - send.Tau_Min) / 4095.0f,
+            send.Tau_Min,
+            (int8_t)j,
+        };
+    }
+}
+
+/// @brief 发送一帧8字节标准帧
+/// @param dev 模块设备号, can_transports_ 下标
+/// @param channel 适配器上的通道号
+/// @param can_id 帧ID
+/// @param data 8字节数据
+void Tangair_usb2can::CAN_Send_Frame(int32_t dev, uint8_t channel, uint32_t can_id, const uint8_t *data)
+{
+    CanFrame frame;
+    frame.channel = channel;
+    frame.can_id = can_id;
+    frame.dlc = 8;
+    std::memcpy(frame.data, data, 8);
+    frame.timestamp_ns = 0;
+    can_transports_[dev]->Send(&frame, 1);
+
+    flight_recorder_.Append(kFlightStreamTx, kFlightRecordTxFrame, FlightChannel(dev, channel), can_id, data, 8, MonotonicNowNs());
 }
 
 /// @brief 使能
@@ -803,19 +1508,8 @@ void Tangair_usb2can::USB2CAN_CAN_Bus_Init()
 /// @param Motor_Data
 void Tangair_usb2can::Motor_Enable(int32_t dev, uint8_t channel, Motor_CAN_Send_Struct *Motor_Data)
 {
-    txMsg_CAN.canID = Motor_Data->id;
-    // printf("0x%02X", txMsg_CAN.canID);
-
-    Data_CAN[0] = 0xFF;
-    Data_CAN[1] = 0xFF;
-    Data_CAN[2] = 0xFF;
-    Data_CAN[3] = 0xFF;
-    Data_CAN[4] = 0xFF;
-    Data_CAN[5] = 0xFF;
-    Data_CAN[6] = 0xFF;
-    Data_CAN[7] = 0xFC;
-
-    int ret = sendUSBCAN(dev, channel, &txMsg_CAN, Data_CAN);
+    const uint8_t data[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, DM_CMD_ENABLE};
+    CAN_Send_Frame(dev, channel, Motor_Data->id, data);
 }
 
 /// @brief 电机失能
@@ -824,18 +1518,8 @@ void Tangair_usb2can::Motor_Enable(int32_t dev, uint8_t channel, Motor_CAN_Send_
 /// @param Motor_Data
 void Tangair_usb2can::Motor_Disable(int32_t dev, uint8_t channel, Motor_CAN_Send_Struct *Motor_Data)
 {
-    txMsg_CAN.canID = Motor_Data->id;
-
-    Data_CAN[0] = 0xFF;
-    Data_CAN[1] = 0xFF;
-    Data_CAN[2] = 0xFF;
-    Data_CAN[3] = 0xFF;
-    Data_CAN[4] = 0xFF;
-    Data_CAN[5] = 0xFF;
-    Data_CAN[6] = 0xFF;
-    Data_CAN[7] = 0xFD;
-
-    sendUSBCAN(dev, channel, &txMsg_CAN, Data_CAN);
+    const uint8_t data[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, DM_CMD_DISABLE};
+    CAN_Send_Frame(dev, channel, Motor_Data->id, data);
 }
 
 /// @brief 设置零点
@@ -844,18 +1528,8 @@ void Tangair_usb2can::Motor_Disable(int32_t dev, uint8_t channel, Motor_CAN_Send
 /// @param Motor_Data
 void Tangair_usb2can::Motor_Zore(int32_t dev, uint8_t channel, Motor_CAN_Send_Struct *Motor_Data)
 {
-    txMsg_CAN.canID = Motor_Data->id;
-
-    Data_CAN[0] = 0xFF;
-    Data_CAN[1] = 0xFF;
-    Data_CAN[2] = 0xFF;
-    Data_CAN[3] = 0xFF;
-    Data_CAN[4] = 0xFF;
-    Data_CAN[5] = 0xFF;
-    Data_CAN[6] = 0xFF;
-    Data_CAN[7] = 0xFE;
-
-    sendUSBCAN(dev, channel, &txMsg_CAN, Data_CAN);
+    const uint8_t data[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, DM_CMD_ZERO};
+    CAN_Send_Frame(dev, channel, Motor_Data->id, data);
 }
 
 /// @brief 电机控制
@@ -864,12 +1538,6 @@ void Tangair_usb2can::Motor_Zore(int32_t dev, uint8_t channel, Motor_CAN_Send_St
 /// @param Motor_Data 电机数据
 void Tangair_usb2can::CAN_Send_Control(int32_t dev, uint8_t channel, Motor_CAN_Send_Struct *Motor_Data) 
 {
-    // 运控模式专用的局部变
-    FrameInfo txMsg_Control = {
-        .canID = Motor_Data->id,
-        .frameType = STANDARD,
-        .dataLength = 8,
-    };
     uint8_t Data_CAN_Control[8];
 
     //限制范围
@@ -893,7 +1561,7 @@ void Tangair_usb2can::CAN_Send_Control(int32_t dev, uint8_t channel, Motor_CAN_S
     Data_CAN_Control[6] = ((float_to_uint(Motor_Data->kd, KD_MIN, KD_MAX, 12)&0xF)<<4)|(float_to_uint(Motor_Data->torque, Motor_Data->Tau_Min, Motor_Data->Tau_Max, 12)>>8); //KP �?? 4 位扭矩高 4 �??
     Data_CAN_Control[7] = float_to_uint(Motor_Data->torque, Motor_Data->Tau_Min, Motor_Data->Tau_Max, 12)&0xFF; //扭矩�?? 8
 
-    int ret = sendUSBCAN(dev, channel, &txMsg_Control, Data_CAN_Control);
+    CAN_Send_Frame(dev, channel, Motor_Data->id, Data_CAN_Control);
 }
 
 /// @brief 电机阻尼模式
@@ -910,304 +1578,381 @@ void Tangair_usb2can::Motor_Passive_SET(int32_t dev, uint8_t channel, Motor_CAN_
     CAN_Send_Control(dev, channel, Motor_Data);
 }
 
-void Tangair_usb2can::ENABLE_ALL_MOTOR(int delay_us)
+/// @brief 按调度表顺序发送, 各总线交替即并行传输
+MotorSequenceResult Tangair_usb2can::ENABLE_ALL_MOTOR(int delay_us)
 {   
-    // FRH
-    Motor_Enable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_1_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RRH
-    Motor_Enable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_1_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // FLH
-    Motor_Enable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_5_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RLH
-    Motor_Enable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_5_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-
-    // FRT
-    Motor_Enable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_2_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RRT
-    Motor_Enable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_2_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // FLT
-    Motor_Enable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_6_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RLT
-    Motor_Enable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_6_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-
-    // FRC
-    Motor_Enable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_3_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RRC
-    Motor_Enable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_3_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // FLC
-    Motor_Enable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_7_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RLC
-    Motor_Enable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_7_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-}
-
-void Tangair_usb2can::DISABLE_ALL_MOTOR(int delay_us)
+    return RunMotorSequence(MotorCommand::kEnable, kAllJointsMask, delay_us);
+}
+
+MotorSequenceResult Tangair_usb2can::DISABLE_ALL_MOTOR(int delay_us)
 {
-    // FRH
-    Motor_Disable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_1_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RRH
-    Motor_Disable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_1_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // FLH
-    Motor_Disable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_5_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RLH
-    Motor_Disable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_5_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-
-    // FRT
-    Motor_Disable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_2_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RRT
-    Motor_Disable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_2_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // FLT
-    Motor_Disable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_6_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RLT
-    Motor_Disable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_6_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-
-    // FRC
-    Motor_Disable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_3_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RRC
-    Motor_Disable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_3_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // FLC
-    Motor_Disable(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_7_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RLC
-    Motor_Disable(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_7_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-}
-
-void Tangair_usb2can::ZERO_ALL_MOTOR(int delay_us)
+    return RunMotorSequence(MotorCommand::kDisable, kAllJointsMask, delay_us);
+}
+
+/// @brief 目前只对 FR 腿的三个关节置零, 其余关节保持原零点
+MotorSequenceResult Tangair_usb2can::ZERO_ALL_MOTOR(int delay_us)
 {
-    // FRH
-    Motor_Zore(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_1_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // // RRH
-    // Motor_Zore(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_1_motor_send);
-    // std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // // FLH
-    // Motor_Zore(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_5_motor_send);
-    // std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // // RLH
-    // Motor_Zore(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_5_motor_send);
-    // std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-
-    // FRT
-    Motor_Zore(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_2_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // // RRT
-    // Motor_Zore(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_2_motor_send);
-    // std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // // FLT
-    // Motor_Zore(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_6_motor_send);
-    // std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // // RLT
-    // Motor_Zore(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_6_motor_send);
-    // std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-
-    // FRC
-    Motor_Zore(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_3_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // // RRC
-    // Motor_Zore(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_3_motor_send);
-    // std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // // FLC
-    // Motor_Zore(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_7_motor_send);
-    // std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // // RLC
-    // Motor_Zore(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_7_motor_send);
-    // std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-}
-
-void Tangair_usb2can::PASSIVE_ALL_MOTOR(int delay_us)
+    return RunMotorSequence(MotorCommand::kZero, 0x7u, delay_us);
+}
+
+MotorSequenceResult Tangair_usb2can::PASSIVE_ALL_MOTOR(int delay_us)
 {   
-    // FRH
-    Motor_Passive_SET(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_1_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RRH
-    Motor_Passive_SET(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_1_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // FLH
-    Motor_Passive_SET(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_5_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RLH
-    Motor_Passive_SET(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_5_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-
-    // FRT
-    Motor_Passive_SET(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_2_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RRT
-    Motor_Passive_SET(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_2_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // FLT
-    Motor_Passive_SET(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_6_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RLT
-    Motor_Passive_SET(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_6_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-
-    // FRC
-    Motor_Passive_SET(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_3_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RRC
-    Motor_Passive_SET(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_3_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // FLC
-    Motor_Passive_SET(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_7_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
-    // RLC
-    Motor_Passive_SET(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_7_motor_send);
-    std::this_thread::sleep_for(std::chrono::microseconds(delay_us)); // 单位us
+    return RunMotorSequence(MotorCommand::kPassive, kAllJointsMask, delay_us);
 }
 
-/// @brief can控制发送，12个电机的数据
-// 目前能达到1000hz的控制频率--------3000hz的总线发送频率---------同一路can的发送间隔在300us
-void Tangair_usb2can::CAN_TX_ALL_MOTOR(int delay_us)
+void Tangair_usb2can::SendMotorCommand(MotorCommand command, const CAN_TX_Slot_Struct &tx)
 {
-    auto t = std::chrono::high_resolution_clock::now();//这一句耗时50us
-
-    //FRH
-    CAN_Send_Control(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_1_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-    //RRH
-    CAN_Send_Control(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_1_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-    //FLH
-    CAN_Send_Control(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_5_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-    //RLH
-    CAN_Send_Control(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_5_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-
-    //FRT
-    CAN_Send_Control(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_2_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-    //RRT
-    CAN_Send_Control(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_2_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-    //FLT
-    CAN_Send_Control(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_6_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-    //RLT
-    CAN_Send_Control(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_6_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-
-    //FRC
-    CAN_Send_Control(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_3_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-    //RRC
-    CAN_Send_Control(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_3_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-    //FLC
-    CAN_Send_Control(USB2CAN0_, 2, &USB2CAN0_CAN_Bus_2.ID_7_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
-    //RLC
-    CAN_Send_Control(USB2CAN0_, 1, &USB2CAN0_CAN_Bus_1.ID_7_motor_send);
-    t += std::chrono::microseconds(delay_us);
-    std::this_thread::sleep_until(t);
+    switch (command) {
+    case MotorCommand::kEnable:  Motor_Enable(tx.adapter, tx.channel, tx.motor); break;
+    case MotorCommand::kDisable: Motor_Disable(tx.adapter, tx.channel, tx.motor); break;
+    case MotorCommand::kZero:    Motor_Zore(tx.adapter, tx.channel, tx.motor); break;
+    case MotorCommand::kPassive: Motor_Passive_SET(tx.adapter, tx.channel, tx.motor); break;
+    }
 }
 
-/// @brief 辅助函数
-Matrix3x4d mujoco_ang2real_ang(const std::vector<double>& dof_pos) {
-    std::vector<std::string> motor_order = {
-        "frd", "fld", "rrd", "rld",  // Lower legs
-        "fru", "flu", "rru", "rlu",  // Upper legs
-        "frh", "flh", "rrh", "rlh"   // Hips
-    };
-
-    std::vector<std::string> mujoco_order = {
-        "frh", "fru", "frd",
-        "flh", "flu", "fld",
-        "rrh", "rru", "rrd",
-        "rlh", "rlu", "rld"
-    };
-
-    std::vector<int> index_map;
-    for (const auto& name : motor_order) {
-        auto it = std::find(mujoco_order.begin(), mujoco_order.end(), name);
-        if (it == mujoco_order.end()) {
-            throw std::runtime_error("Motor name not found in mujoco_order: " + name);
+/// @brief 向 joint_mask (DDS序号) 中的电机发送命令并等待各自的反馈
+/// 每轮只向尚未确认的电机发送, 等待 reply_timeout_us 后重发, 共 retries + 1 轮
+/// 使能 / 失能要求反馈的状态码与命令一致, 置零 / 阻尼收到反馈即可; 故障码不再重发
+MotorSequenceResult Tangair_usb2can::RunMotorSequence(MotorCommand command, uint32_t joint_mask, int delay_us)
+{
+    std::lock_guard<std::mutex> lock(motor_sequence_mutex_);
+
+    MotorSequenceResult result;
+    const int64_t start_ns = MonotonicNowNs();
+    const int64_t timeout_ns = (int64_t)std::max(motor_sequence_config_.reply_timeout_us, 1) * 1000;
+    const int rounds = std::max(motor_sequence_config_.retries, 0) + 1;
+    const auto slot = std::chrono::microseconds(std::max(delay_us, CAN_FRAME_TIME_US));
+
+    uint32_t pending = joint_mask & kAllJointsMask;
+    for (int j = 0; j < NUM_MOTOR; ++j)
+        if ((pending >> j) & 1u)
+            result.status[j] = MotorAckStatus::kTimeout;
+
+    for (int round = 0; round < rounds && pending; ++round) {
+        // 发送前的应答序号, 之后到达的反馈才算本轮的确认
+        std::array<uint32_t, NUM_MOTOR> ack_base;
+        for (int j = 0; j < NUM_MOTOR; ++j)
+            ack_base[j] = rx_ack_seq_[j].load(std::memory_order_acquire);
+        reply_wait_mask_.store(pending, std::memory_order_release);
+        uint64_t events = 0;
+        (void)!read(reply_fd_, &events, sizeof(events));
+
+        // 每路can只等待本总线上一帧的占用时间, 调度表中各总线交替排列
+        std::vector<BusFreeTimes> bus_free_time(can_transports_.size());
+        for (int i = 0; i < kNumTxSlots; ++i) {
+            const int j = tx_slot_joint_[i];
+            if (j < 0 || !((pending >> j) & 1u))
+                continue;
+            const CAN_TX_Slot_Struct &tx = tx_schedule_[i];
+            auto &bus_free = bus_free_time[tx.adapter][tx.channel];
+            auto now = steady_clock::now();
+            if (tx_pacing_ && now < bus_free) {
+                std::this_thread::sleep_until(bus_free);
+                now = bus_free;
+            }
+            SendMotorCommand(command, tx);
+            ++result.attempts[j];
+            bus_free = now + slot;
         }
-        index_map.push_back(std::distance(mujoco_order.begin(), it));
-    }
 
-    std::vector<double> reordered_dof_pos;
-    for (int i : index_map) {
-        reordered_dof_pos.push_back(dof_pos[i]);
+        const int64_t deadline_ns = MonotonicNowNs() + timeout_ns;
+        while (pending) {
+            for (int j = 0; j < NUM_MOTOR; ++j) {
+                const uint32_t bit = 1u << j;
+                if (!(pending & bit))
+                    continue;
+                const uint32_t seq = rx_ack_seq_[j].load(std::memory_order_acquire);
+                if (seq == ack_base[j])
+                    continue;
+                ack_base[j] = seq;
+
+                const uint8_t state = rx_state_[j].load(std::memory_order_relaxed);
+                result.state[j] = state;
+                if (state >= DM_STATE_FAULT_MIN) {
+                    result.status[j] = MotorAckStatus::kFault;
+                    pending &= ~bit;
+                } else if ((command != MotorCommand::kEnable || state == DM_STATE_ENABLED) &&
+                           (command != MotorCommand::kDisable || state == DM_STATE_DISABLED)) {
+                    result.status[j] = MotorAckStatus::kOk;
+                    pending &= ~bit;
+                }
+                // 状态不符时等待该电机的下一帧反馈, 本轮超时后重发
+            }
+            reply_wait_mask_.store(pending, std::memory_order_release);
+
+            const int64_t remaining_ns = deadline_ns - MonotonicNowNs();
+            if (!pending || remaining_ns <= 0)
+                break;
+            WaitMotorReplies(pending, remaining_ns);
+        }
     }
 
-    Matrix3x4d result;
-    result << 
-        -reordered_dof_pos[0],  reordered_dof_pos[1],  -reordered_dof_pos[2],  reordered_dof_pos[3],
-        -reordered_dof_pos[4],  reordered_dof_pos[5],  -reordered_dof_pos[6],  reordered_dof_pos[7],
-        reordered_dof_pos[8],  reordered_dof_pos[9],  -reordered_dof_pos[10], -reordered_dof_pos[11];
+    reply_wait_mask_.store(0, std::memory_order_relaxed);
+    result.elapsed_ns = MonotonicNowNs() - start_ns;
     return result;
 }
 
-std::vector<double> real_ang2mujoco_ang(const std::vector<double>& dof_pos) {
-    std::vector<std::string> motor_order = {
-        "frd", "fld", "rrd", "rld",  // Lower legs
-        "fru", "flu", "rru", "rlu",  // Upper legs
-        "frh", "flh", "rrh", "rlh"   // Hips
-    };
-
-    std::vector<std::string> mujoco_order = {
-        "frh", "fru", "frd",
-        "flh", "flu", "fld",
-        "rrh", "rru", "rrd",
-        "rlh", "rlu", "rld"
-    };
-
-    // 建立 motor_order 名稱到 index 的映射
-    std::unordered_map<std::string, int> name_to_index;
-    for (int i = 0; i < motor_order.size(); ++i) {
-        name_to_index[motor_order[i]] = i;
+/// @brief 等待 pending 中的电机的反馈, 最多 timeout_ns
+/// 有 RX 线程或 io_reactor 接收的适配器由其解码后唤醒; 没有时在本线程直接接收解码
+void Tangair_usb2can::WaitMotorReplies(uint32_t pending, int64_t timeout_ns)
+{
+    // 最长等待1ms再检查一次, RX线程可能在此期间退出
+    constexpr int64_t kMaxWaitNs = 1000000;
+    const int64_t wait_ns = std::min(timeout_ns, kMaxWaitNs);
+
+    uint32_t adapters = 0;
+    for (int j = 0; j < NUM_MOTOR; ++j)
+        if ((pending >> j) & 1u)
+            adapters |= 1u << joints_[j].adapter;
+    const uint32_t unserviced = adapters & ~rx_serviced_mask_.load(std::memory_order_acquire);
+
+    if (unserviced) {
+        CanFrame rx_frames[kRxBatch];
+        bool first = true;
+        for (int a = 0; a < NumAdapters(); ++a) {
+            if (!((unserviced >> a) & 1u))
+                continue;
+            // 只在第一个适配器上阻塞, 其余只取已到达的帧
+            const int n = can_transports_[a]->Receive(rx_frames, kRxBatch, first ? (int)(wait_ns / 1000) : 0);
+            first = false;
+            if (n > 0)
+                CAN_RX_DecodeBatch(rx_frames, n, a);
+        }
+        return;
     }
 
-    // 依照 mujoco_order 重排
-    std::vector<double> reordered_dof_pos;
-    for (const auto& name : mujoco_order) {
-        reordered_dof_pos.push_back(dof_pos[name_to_index[name]]);
+    struct pollfd pfd = {reply_fd_, POLLIN, 0};
+    struct timespec ts = {(time_t)(wait_ns / 1000000000LL), (long)(wait_ns % 1000000000LL)};
+    if (ppoll(&pfd, 1, &ts, nullptr) > 0) {
+        uint64_t events = 0;
+        (void)!read(reply_fd_, &events, sizeof(events));
     }
+}
 
-    // 依照特定規則調整正負號
-    reordered_dof_pos[1] = -reordered_dof_pos[1];
-    reordered_dof_pos[2] = -reordered_dof_pos[2];
-    reordered_dof_pos[6] = -reordered_dof_pos[6];
-    reordered_dof_pos[7] = -reordered_dof_pos[7];
-    reordered_dof_pos[8] = -reordered_dof_pos[8];
-    reordered_dof_pos[9] = -reordered_dof_pos[9];
+void Tangair_usb2can::PrintMotorSequenceResult(const char *name, const MotorSequenceResult &result) const
+{
+    int total = 0, ok = 0;
+    for (int j = 0; j < NUM_MOTOR; ++j) {
+        total += result.status[j] != MotorAckStatus::kSkipped;
+        ok += result.status[j] == MotorAckStatus::kOk;
+    }
+    std::cout << "[INFO] " << name << ": " << ok << "/" << total << " motors acknowledged in "
+              << result.elapsed_ns / 1000 << " us" << std::endl;
+
+    for (int j = 0; j < NUM_MOTOR; ++j) {
+        if (result.status[j] != MotorAckStatus::kFault && result.status[j] != MotorAckStatus::kTimeout)
+            continue;
+        const JointDescriptor &joint = joints_[j];
+        std::cerr << "[ERROR] " << name << ": joint " << j << " (dev" << (int)joint.adapter << " can" << (int)joint.bus
+                  << " id 0x" << std::hex << (int)joint.can_id << std::dec << ") "
+                  << (result.status[j] == MotorAckStatus::kFault ? "fault" : "timeout")
+                  << ", state " << (int)result.state[j] << ", attempts " << (int)result.attempts[j] << std::endl;
+    }
+}
 
-    return reordered_dof_pos;
+/// @brief TX调度表初始化, 各总线按 bus_joint_order_ 的顺序交替排列, 不同总线上的相邻帧并行传输
+/// 默认拓扑下为 FRH RRH FLH RLH, FRT RRT FLT RLT, FRC RRC FLC RLC
+void Tangair_usb2can::CAN_TX_Schedule_Init()
+{
+    int n = 0;
+    for (size_t k = 0; n < kNumTxSlots; ++k)
+        for (const std::vector<int> &bus : bus_joint_order_)
+            if (k < bus.size() && n < kNumTxSlots) {
+                const int j = bus[k];
+                tx_schedule_[n] = {joints_[j].bus, &motor_send_[j], joints_[j].adapter};
+                tx_slot_joint_[n] = (int8_t)j;
+                ++n;
+            }
+
+    for (int i = 0; i < kNumTxSlots; ++i)
+        tx_codec_.SetTorqueLimits(i, tx_schedule_[i].motor->Tau_Min, tx_schedule_[i].motor->Tau_Max);
+
+    bus_free_time_.assign(can_transports_.size(), BusFreeTimes{});
+    last_tx_cycle_start_ = steady_clock::time_point{};
+    ResetTxCycleStats();
+}
+
+/// @brief can控制发送，12个电机的数据
+/// 先整体批量编码12帧, 再按总线节拍逐帧发送
+/// 每路can只等待本总线上一帧的占用时间, 各总线互不阻塞, 一个周期约 (每路帧数) * max(delay_us, CAN_FRAME_TIME_US)
+/// 第1个适配器在本线程发送, 其余适配器由各自的TX线程并行发送 (未启动时同样在本线程依次发送)
+/// @param delay_us 同一路can上相邻两帧的最小间隔
+void Tangair_usb2can::CAN_TX_ALL_MOTOR(int delay_us)
+{
+    auto cycle_start = steady_clock::now();
+    const int64_t encode_start_ns = MonotonicNowNs();
+
+    for (int i = 0; i < kNumTxSlots; ++i)
+    {
+        const Motor_CAN_Send_Struct &motor = *tx_schedule_[i].motor;
+        tx_batch_.position[i] = motor.position;
+        tx_batch_.velocity[i] = motor.speed;
+        tx_batch_.kp[i] = motor.kp;
+        tx_batch_.kd[i] = motor.kd;
+        tx_batch_.torque[i] = motor.torque;
+    }
+    tx_codec_.Encode(tx_batch_, tx_payload_);
+    stage_latency_.Record(kStageTxEncode, MonotonicNowNs() - encode_start_ns);
+
+    // 新周期: 等待12路反馈, 上一周期的发出时间因周期号不同自然失效
+    rx_pending_mask_.store(kAllJointsMask, std::memory_order_relaxed);
+    const uint32_t cycle = tx_cycle_seq_.fetch_add(1, std::memory_order_release) + 1;
+
+    const bool workers = tx_workers_active_.load(std::memory_order_acquire);
+    if (workers) {
+        TxWorkerCycle work;
+        work.cycle = cycle;
+        work.delay_us = delay_us;
+        std::memcpy(work.payload, tx_payload_, sizeof(work.payload));
+        tx_worker_cycle_.Store(work);
+        const uint64_t one = 1;
+        for (int a = 1; a < NumAdapters(); ++a)
+            (void)!write(tx_worker_fd_[a], &one, sizeof(one));
+    }
+    for (int a = 0; a < (workers ? 1 : NumAdapters()); ++a)
+        CAN_TX_Adapter(a, tx_payload_, cycle, delay_us);
+
+    // 周期统计: 相邻两次发送开始的间隔
+    if (last_tx_cycle_start_ != steady_clock::time_point{})
+    {
+        int64_t cycle_ns = duration_cast<nanoseconds>(cycle_start - last_tx_cycle_start_).count();
+        uint64_t n = tx_cycle_count_.load(std::memory_order_relaxed);
+
+        tx_cycle_last_ns_.store(cycle_ns, std::memory_order_relaxed);
+        if (n == 0 || cycle_ns < tx_cycle_min_ns_.load(std::memory_order_relaxed))
+            tx_cycle_min_ns_.store(cycle_ns, std::memory_order_relaxed);
+        if (cycle_ns > tx_cycle_max_ns_.load(std::memory_order_relaxed))
+            tx_cycle_max_ns_.store(cycle_ns, std::memory_order_relaxed);
+        tx_cycle_total_ns_.fetch_add(cycle_ns, std::memory_order_relaxed);
+        tx_cycle_count_.store(n + 1, std::memory_order_release);
+    }
+    last_tx_cycle_start_ = cycle_start;
+}
+
+/// @brief 发送一个适配器上的各槽位, 同一路can上相邻两帧至少间隔 max(delay_us, CAN_FRAME_TIME_US)
+void Tangair_usb2can::CAN_TX_Adapter(int adapter, const uint8_t (*payload)[8], uint32_t cycle, int delay_us)
+{
+    const auto slot = std::chrono::microseconds(std::max(delay_us, CAN_FRAME_TIME_US));
+    BusFreeTimes &bus_free_time = bus_free_time_[adapter];
+
+    for (int i = 0; i < kNumTxSlots; ++i)
+    {
+        const CAN_TX_Slot_Struct &tx = tx_schedule_[i];
+        if (tx.adapter != adapter)
+            continue;
+        auto &bus_free = bus_free_time[tx.channel];
+        auto now = steady_clock::now();
+        if (tx_pacing_ && now < bus_free)
+        {
+            std::this_thread::sleep_until(bus_free);
+            now = bus_free;
+        }
+
+        const int64_t send_ns = MonotonicNowNs();
+        CAN_Send_Frame(adapter, tx.channel, tx.motor->id, payload[i]);
+        const int64_t sent_ns = MonotonicNowNs();
+        stage_latency_.Record(kStageTxFrame, sent_ns - send_ns);
+        if (tx_slot_joint_[i] >= 0)
+            tx_sent_[tx_slot_joint_[i]].Store({cycle, sent_ns});
+        bus_free = now + slot;
+    }
+}
+
+TxCycleStats Tangair_usb2can::GetTxCycleStats()
+{
+    TxCycleStats stats;
+    stats.cycles  = tx_cycle_count_.load(std::memory_order_acquire);
+    stats.last_ns = tx_cycle_last_ns_.load(std::memory_order_relaxed);
+    stats.min_ns  = tx_cycle_min_ns_.load(std::memory_order_relaxed);
+    stats.max_ns  = tx_cycle_max_ns_.load(std::memory_order_relaxed);
+    stats.avg_ns  = stats.cycles ? tx_cycle_total_ns_.load(std::memory_order_relaxed) / (int64_t)stats.cycles : 0;
+    return stats;
+}
+
+void Tangair_usb2can::ResetTxCycleStats()
+{
+    tx_cycle_last_ns_ = 0;
+    tx_cycle_min_ns_ = 0;
+    tx_cycle_max_ns_ = 0;
+    tx_cycle_total_ns_ = 0;
+    tx_cycle_count_ = 0;
+}
+
+/// @brief 辅助函数
+// 关节名称顺序, 电机矩阵按行展开 (row 0: 小腿, row 1: 大腿, row 2: 髋) 与 mujoco 顺序
+namespace
+{
+constexpr std::array<std::string_view, 12> kMotorOrder = {
+    "frd", "fld", "rrd", "rld",  // Lower legs
+    "fru", "flu", "rru", "rlu",  // Upper legs
+    "frh", "flh", "rrh", "rlh"   // Hips
+};
+
+constexpr std::array<std::string_view, 12> kMujocoOrder = {
+    "frh", "fru", "frd",
+    "flh", "flu", "fld",
+    "rrh", "rru", "rrd",
+    "rlh", "rlu", "rld"
+};
+
+constexpr int IndexOf(const std::array<std::string_view, 12>& names, std::string_view name) {
+    for (int i = 0; i < 12; ++i)
+        if (names[i] == name) return i;
+    return -1;
+}
+
+// perm[i] = from 中与 to[i] 同名关节的序号
+constexpr std::array<int, 12> MakePermutation(const std::array<std::string_view, 12>& from,
+                                              const std::array<std::string_view, 12>& to) {
+    std::array<int, 12> perm{};
+    for (int i = 0; i < 12; ++i)
+        perm[i] = IndexOf(from, to[i]);
+    return perm;
+}
+
+constexpr std::array<int, 12> kMujocoToReal = MakePermutation(kMujocoOrder, kMotorOrder);
+constexpr std::array<int, 12> kRealToMujoco = MakePermutation(kMotorOrder, kMujocoOrder);
+
+// 方向, 分别按电机矩阵展开顺序与 mujoco 顺序
+constexpr std::array<double, 12> kMujocoToRealSign = {
+    -1,  1, -1,  1,
+    -1,  1, -1,  1,
+     1,  1, -1, -1
+};
+constexpr std::array<double, 12> kRealToMujocoSign = {
+     1, -1, -1,
+     1,  1,  1,
+    -1, -1, -1,
+    -1,  1,  1
+};
+
+constexpr bool IsPermutation(const std::array<int, 12>& perm) {
+    for (int i = 0; i < 12; ++i) {
+        if (perm[i] < 0) return false;
+        for (int j = i + 1; j < 12; ++j)
+            if (perm[i] == perm[j]) return false;
+    }
+    return true;
+}
+
+static_assert(IsPermutation(kMujocoToReal), "motor_order and mujoco_order must name the same joints");
+static_assert(IsPermutation(kRealToMujoco), "motor_order and mujoco_order must name the same joints");
+} // namespace
+
+Matrix3x4d mujoco_ang2real_ang(const std::array<double, 12>& dof_pos) {
+    Matrix3x4d result;
+    for (int k = 0; k < 12; ++k)
+        result(k / 4, k % 4) = kMujocoToRealSign[k] * dof_pos[kMujocoToReal[k]];
+    return result;
+}
+
+std::array<double, 12> real_ang2mujoco_ang(const Matrix3x4d& real_ang) {
+    std::array<double, 12> result;
+    for (int m = 0; m < 12; ++m) {
+        const int k = kRealToMujoco[m];
+        result[m] = kRealToMujocoSign[m] * real_ang(k / 4, k % 4);
+    }
+    return result;
 }
 
 void PrintMatrix(const std::string& name, const Eigen::Matrix<double, 3, 4>& matrix) {